@@ -0,0 +1,239 @@
+#pragma once
+
+#include "../memory_device.hpp"
+#include "base_allocator.hpp"
+
+namespace rambock {
+namespace allocators {
+
+/** Buddy allocator for power-of-two blocks
+ * Memory is divided into blocks of MinBlockSize << order bytes, header
+ * included. Every block of order k lies at an offset aligned to its size, so
+ * the block it was split from and its buddy are found by address arithmetic.
+ * Allocating splits a larger free block in halves until the requested order
+ * is reached, freeing merges a block with its buddy for as long as the buddy
+ * is free as well. Both take O(OrderCount) device transactions.
+ *
+ * Free blocks are kept in doubly linked lists per order, the heads of which
+ * live in local memory.
+ */
+template <size_t OrderCount = 16, Size MinBlockSize = 16>
+class BuddyAllocator : public BaseAllocator {
+	static_assert(OrderCount > 0 && OrderCount < 32,
+				  "order count must fit into a header");
+	static_assert(MinBlockSize >= 12 &&
+					  (MinBlockSize & (MinBlockSize - 1)) == 0,
+				  "blocks must hold a free list node and be a power of two");
+	static_assert((MinBlockSize << (OrderCount - 1)) >> (OrderCount - 1) ==
+					  MinBlockSize,
+				  "largest block must be addressable");
+
+	/** Stored in front of every block
+	 * Holds the order of the block and FREE if it is not allocated.
+	 */
+	using Header = Size;
+	static constexpr Header FREE = Header(1) << 31;
+
+	/** Free list entry at the beginning of a free block
+	 */
+	struct Node {
+		Header header;
+		Address next, previous;
+	};
+
+	static inline Size block_size(size_t order) {
+		return MinBlockSize << order;
+	}
+
+	/** Find the smallest order fitting a block
+	 * @param size block size including header
+	 * @return order or OrderCount if no order fits
+	 */
+	static size_t order_of(Size size);
+
+	/** Find the buddy of a block
+	 * @return buddy or null if the block has no buddy in memory
+	 */
+	Address buddy_of(Address block, size_t order) const;
+
+	// unlinked blocks must be pushed or have their header rewritten
+	void push(Address block, size_t order);
+	Address pop(size_t order);
+	void unlink(const Node &node, size_t order);
+
+	Address _heads[OrderCount];
+	// all blocks lie between _base and _end
+	Address _base;
+	Address _end;
+	Size _free_bytes;
+
+  public:
+	/** Constructor
+	 * @param end the address just past the last addressable byte
+	 */
+	BuddyAllocator(MemoryDevice &memory_device, Address end);
+
+	Address allocate(Size count) override;
+	Size free(Address address) override;
+	Size get_free_bytes() const override;
+};
+
+template <size_t N, Size M>
+BuddyAllocator<N, M>::BuddyAllocator(MemoryDevice &memory_device, Address end)
+	: BaseAllocator(memory_device)
+	, _heads{}
+	// steer clear of NULL
+	, _base{32}
+	, _end{end}
+	, _free_bytes{0} {
+	// cover memory with the largest blocks fitting, each aligned to its size
+	Address block = _base;
+	for (size_t order = N; order-- > 0;) {
+		while (_end > block && _end - block >= block_size(order)) {
+			push(block, order);
+			_free_bytes += block_size(order);
+			block += block_size(order);
+			if (order + 1 < N) {
+				// smaller orders are needed at most once
+				break;
+			}
+		}
+	}
+}
+
+template <size_t N, Size M>
+Address BuddyAllocator<N, M>::allocate(Size count) {
+	const size_t order = order_of(sizeof(Header) + count);
+	if (order == N) {
+		return Address::null();
+	}
+
+	// find the smallest free block large enough
+	size_t larger = order;
+	while (larger < N && !_heads[larger]) {
+		larger++;
+	}
+	if (larger == N) {
+		return Address::null();
+	}
+
+	// halve the block, keeping the lower half and freeing the upper one
+	Address block = pop(larger);
+	while (larger > order) {
+		larger--;
+		push(block + block_size(larger), larger);
+	}
+	const Header header = Header(order);
+	memory_device().write(block, &header, sizeof(header));
+
+	_free_bytes -= block_size(order);
+	return block + sizeof(Header);
+}
+
+template <size_t N, Size M>
+Size BuddyAllocator<N, M>::free(Address address) {
+	if (address < _base + sizeof(Header) || address >= _end) {
+		return 0;
+	}
+	Address block = address - sizeof(Header);
+	Header header{};
+	memory_device().read(&header, block, sizeof(header));
+	if (header >= N) {
+		// already free or not a block of this allocator
+		return 0;
+	}
+	size_t order = header;
+	const Size size = block_size(order);
+	_free_bytes += size;
+	// mark the block free even if it is absorbed by its buddy below, so
+	// freeing it again is caught
+	header |= FREE;
+	memory_device().write(block, &header, sizeof(header));
+
+	// merge with the buddy as long as it is free and not split
+	for (Address buddy = buddy_of(block, order); buddy;
+		 buddy = buddy_of(block, order)) {
+		Node node{};
+		memory_device().read(&node, buddy, sizeof(node));
+		if (node.header != (Header(order) | FREE)) {
+			break;
+		}
+		unlink(node, order);
+		if (buddy < block) {
+			block = buddy;
+		}
+		order++;
+	}
+	push(block, order);
+	return size - sizeof(Header);
+}
+
+template <size_t N, Size M>
+Size BuddyAllocator<N, M>::get_free_bytes() const {
+	return _free_bytes;
+}
+
+template <size_t N, Size M> size_t BuddyAllocator<N, M>::order_of(Size size) {
+	for (size_t order = 0; order < N; order++) {
+		if (size <= block_size(order)) {
+			return order;
+		}
+	}
+	return N;
+}
+
+template <size_t N, Size M>
+Address BuddyAllocator<N, M>::buddy_of(Address block, size_t order) const {
+	if (order + 1 >= N) {
+		// largest blocks are never merged
+		return Address::null();
+	}
+	const Size offset = (block - _base) ^ block_size(order);
+	// blocks at the end of memory may lack a buddy
+	if (offset + block_size(order) > _end - _base) {
+		return Address::null();
+	}
+	return _base + offset;
+}
+
+template <size_t N, Size M>
+void BuddyAllocator<N, M>::push(Address block, size_t order) {
+	const Node node{Header(order) | FREE, _heads[order], Address::null()};
+	memory_device().write(block, &node, sizeof(node));
+	if (node.next) {
+		memory_device().write(node.next + offsetof(Node, previous),
+							  &block,
+							  sizeof(block));
+	}
+	_heads[order] = block;
+}
+
+template <size_t N, Size M> Address BuddyAllocator<N, M>::pop(size_t order) {
+	const Address block = _heads[order];
+	if (block) {
+		Address next{};
+		memory_device().read(
+			&next, block + offsetof(Node, next), sizeof(next));
+		unlink(Node{Header(order) | FREE, next, Address::null()}, order);
+	}
+	return block;
+}
+
+template <size_t N, Size M>
+void BuddyAllocator<N, M>::unlink(const Node &node, size_t order) {
+	if (node.previous) {
+		memory_device().write(node.previous + offsetof(Node, next),
+							  &node.next,
+							  sizeof(node.next));
+	} else {
+		_heads[order] = node.next;
+	}
+	if (node.next) {
+		memory_device().write(node.next + offsetof(Node, previous),
+							  &node.previous,
+							  sizeof(node.previous));
+	}
+}
+
+} // namespace allocators
+} // namespace rambock
@@ -26,11 +26,12 @@ class BumpAllocator : public BaseAllocator {
 	Size get_free_bytes() const override;
 };
 
-BumpAllocator::BumpAllocator(MemoryDevice &memory_device, const Address end)
+inline BumpAllocator::BumpAllocator(MemoryDevice &memory_device,
+									 const Address end)
 	: BaseAllocator(memory_device)
 	, _end{end} {}
 
-Address BumpAllocator::allocate(Size count) {
+inline Address BumpAllocator::allocate(Size count) {
 	if (_base + count < _end) {
 		Address address = _base;
 		_base += count;
@@ -40,12 +41,12 @@ Address BumpAllocator::allocate(Size count) {
 	}
 }
 
-Size BumpAllocator::free(Address address) {
+inline Size BumpAllocator::free(Address address) {
 	// do not reclaim any memory
 	return 0;
 }
 
-Size BumpAllocator::get_free_bytes() const { return _end - _base; }
+inline Size BumpAllocator::get_free_bytes() const { return _end - _base; }
 
 } // namespace allocators
 } // namespace rambock
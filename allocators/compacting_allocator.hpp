@@ -0,0 +1,361 @@
+#pragma once
+
+#include "../memory_device.hpp"
+#include "base_allocator.hpp"
+
+namespace rambock {
+namespace allocators {
+
+/** Allocator that can move blocks to close gaps between them
+ * Allocations are identified by handles instead of physical addresses. An
+ * address handed out holds the handle in its upper bits and an offset into the
+ * block of at most 2^OffsetBits bytes in its lower bits. A local table of
+ * HandleCount entries resolves handles to the current location of their block,
+ * so blocks can be moved without invalidating addresses.
+ *
+ * compact() slides live blocks towards the beginning of memory in chunks of
+ * ChunkSize bytes, doing a bounded amount of work per call. A pass can be
+ * interleaved with any other operation, including accesses to the block being
+ * moved.
+ *
+ * The allocator is also the MemoryDevice that resolves handles,
+ * memory_device() returns it for use with external_ptr and layers.
+ */
+template <size_t HandleCount = 64, Size OffsetBits = 16, Size ChunkSize = 64>
+class CompactingAllocator : public MemoryDevice, public BaseAllocator {
+	static_assert(OffsetBits > 0 && OffsetBits < 32,
+				  "addresses need bits for handles and offsets");
+	static_assert(HandleCount < (uint64_t(1) << (32 - OffsetBits)),
+				  "handles must fit into an address");
+	static_assert(ChunkSize > 0, "chunks must not be empty");
+
+	/** Stored in front of every block, blocks tile memory without gaps
+	 */
+	struct Header {
+		// block size including header
+		Size size;
+		// owning handle or 0 for free blocks
+		Size handle;
+	};
+
+	/** Location of a block
+	 * Unused entries have a size of 0 and hold the next unused handle in
+	 * block.
+	 */
+	struct Entry {
+		Address block;
+		Size size;
+	};
+
+	static constexpr Size OFFSET_MASK = (Size(1) << OffsetBits) - 1;
+
+	MemoryDevice &_physical;
+	inline MemoryDevice &physical() const { return _physical; }
+
+	Entry _table[HandleCount];
+	// first unused handle, 0 if all are in use
+	Size _unused;
+
+	// blocks lie between _base and _top
+	Address _base;
+	Address _top;
+	Address _end;
+	Size _free_bytes;
+
+	/** State of a compaction pass
+	 * Blocks below _compacted have been moved, blocks from _scan on have not
+	 * been looked at. A block being moved is copied from _source to _compacted
+	 * with its first _moved bytes already in place.
+	 */
+	Address _compacted, _scan, _source;
+	Size _moving, _moved;
+
+	inline Entry &entry(Size handle) { return _table[handle - 1]; }
+	Entry *resolve(Address address);
+
+	Header read_header(Address block);
+	void write_header(Address block, Header header);
+
+	/** Find a free block for an allocation, merging adjacent free blocks
+	 * @param from first block to look at
+	 * @param to end of blocks to look at
+	 * @param size block size including header, set to the size found
+	 * @return block of at least size bytes or null
+	 */
+	Address fit(Address from, Address to, Size &size);
+
+	// finish a pass once all blocks were looked at
+	void finish();
+
+  public:
+	/** Constructor
+	 * @param physical the device to store blocks on
+	 * @param physical_end the address just past the last physical byte
+	 */
+	CompactingAllocator(MemoryDevice &physical, Address physical_end);
+
+	Address allocate(Size count) override;
+	Size free(Address address) override;
+	Size get_free_bytes() const override;
+
+	/** Reads from a block
+	 * @return null if the address does not belong to an allocation
+	 */
+	void *read(void *to, Address from, Size count) override;
+
+	/** Writes to a block
+	 * @return null if the address does not belong to an allocation
+	 */
+	Address write(Address to, const void *from, Size count) override;
+
+	/** Continues the current compaction pass or starts a new one
+	 * @param budget number of bytes to read or write at most, plus one chunk
+	 * @return true if the pass is complete
+	 * @note Blocks freed behind a pass leave gaps until the next one
+	 */
+	bool compact(Size budget = Size(-1));
+
+	/** Check whether a compaction pass is in progress
+	 */
+	inline bool is_compacting() const { return _scan != _base; }
+};
+
+template <size_t H, Size O, Size C>
+constexpr Size CompactingAllocator<H, O, C>::OFFSET_MASK;
+
+template <size_t H, Size O, Size C>
+CompactingAllocator<H, O, C>::CompactingAllocator(MemoryDevice &physical,
+												  Address physical_end)
+	: BaseAllocator(static_cast<MemoryDevice &>(*this))
+	, _physical{physical}
+	, _unused{H > 0 ? 1 : 0}
+	// steer clear of NULL
+	, _base{32}
+	, _top{_base}
+	, _end{physical_end}
+	, _free_bytes{physical_end > _base ? physical_end - _base : 0}
+	, _compacted{_base}
+	, _scan{_base}
+	, _source{_base}
+	, _moving{0}
+	, _moved{0} {
+	for (Size handle = 1; handle <= H; handle++) {
+		entry(handle) = Entry{Address(handle < H ? handle + 1 : 0), 0};
+	}
+}
+
+template <size_t H, Size O, Size C>
+Address CompactingAllocator<H, O, C>::allocate(Size count) {
+	if (!_unused || count > OFFSET_MASK) {
+		return Address::null();
+	}
+	Size size = sizeof(Header) + 4 * ((count + 4 - 1) / 4);
+
+	// prefer never used memory, then gaps outside of the current pass
+	Address block = Address::null();
+	if (_top <= _end && _end - _top >= size) {
+		block = _top;
+		_top += size;
+	} else {
+		block = fit(_base, _compacted, size);
+		if (!block) {
+			block = fit(_scan, _top, size);
+		}
+	}
+	if (!block) {
+		return Address::null();
+	}
+
+	const Size handle = _unused;
+	_unused = entry(handle).block.value;
+	entry(handle) = Entry{block, size};
+	write_header(block, Header{size, handle});
+
+	_free_bytes -= size;
+	return Address(handle << O);
+}
+
+template <size_t H, Size O, Size C>
+Size CompactingAllocator<H, O, C>::free(Address address) {
+	Entry *found = resolve(address);
+	if (!found || (address.value & OFFSET_MASK) != 0) {
+		return 0;
+	}
+	const Size handle = address.value >> O;
+	const Entry block = *found;
+
+	if (handle == _moving) {
+		// abandon the move, its memory is part of the gap behind _compacted
+		_moving = 0;
+	} else if (block.block >= _scan && block.block + block.size == _top) {
+		_top = block.block;
+	} else {
+		write_header(block.block, Header{block.size, 0});
+	}
+
+	*found = Entry{Address(_unused), 0};
+	_unused = handle;
+	_free_bytes += block.size;
+	return block.size - sizeof(Header);
+}
+
+template <size_t H, Size O, Size C>
+Size CompactingAllocator<H, O, C>::get_free_bytes() const {
+	return _free_bytes;
+}
+
+template <size_t H, Size O, Size C>
+void *CompactingAllocator<H, O, C>::read(void *to, Address from, Size count) {
+	const Entry *block = resolve(from);
+	if (!block) {
+		return nullptr;
+	}
+	Size offset = sizeof(Header) + (from.value & OFFSET_MASK);
+	uint8_t *bytes = static_cast<uint8_t *>(to);
+	if (from.value >> O == _moving && offset < _moved) {
+		// the beginning of the block was moved already
+		const Size moved = count < _moved - offset ? count : _moved - offset;
+		physical().read(bytes, _compacted + offset, moved);
+		bytes += moved;
+		offset += moved;
+		count -= moved;
+	}
+	if (count) {
+		physical().read(bytes, block->block + offset, count);
+	}
+	return to;
+}
+
+template <size_t H, Size O, Size C>
+Address CompactingAllocator<H, O, C>::write(Address to,
+											const void *from,
+											Size count) {
+	const Entry *block = resolve(to);
+	if (!block) {
+		return Address::null();
+	}
+	Size offset = sizeof(Header) + (to.value & OFFSET_MASK);
+	const uint8_t *bytes = static_cast<const uint8_t *>(from);
+	if (to.value >> O == _moving && offset < _moved) {
+		const Size moved = count < _moved - offset ? count : _moved - offset;
+		physical().write(_compacted + offset, bytes, moved);
+		bytes += moved;
+		offset += moved;
+		count -= moved;
+	}
+	if (count) {
+		physical().write(block->block + offset, bytes, count);
+	}
+	return to;
+}
+
+template <size_t H, Size O, Size C>
+bool CompactingAllocator<H, O, C>::compact(Size budget) {
+	while (budget > 0) {
+		if (_moving) {
+			Entry &block = entry(_moving);
+			Size count = block.size - _moved;
+			count = count < C ? count : C;
+			physical().move(_compacted + _moved, _source + _moved, count);
+			_moved += count;
+			budget -= count < budget ? count : budget;
+
+			if (_moved == block.size) {
+				block.block = _compacted;
+				_compacted += block.size;
+				_moving = 0;
+			}
+			continue;
+		}
+
+		if (_scan >= _top) {
+			finish();
+			return true;
+		}
+
+		const Header header = read_header(_scan);
+		budget -= sizeof(Header) < budget ? sizeof(Header) : budget;
+		if (!header.handle) {
+			// leave free blocks behind
+		} else if (_scan == _compacted) {
+			_compacted += header.size;
+		} else {
+			_source = _scan;
+			_moving = header.handle;
+			_moved = 0;
+		}
+		_scan += header.size;
+	}
+	return false;
+}
+
+template <size_t H, Size O, Size C>
+typename CompactingAllocator<H, O, C>::Entry *
+CompactingAllocator<H, O, C>::resolve(Address address) {
+	const Size handle = address.value >> O;
+	if (handle == 0 || handle > H || entry(handle).size == 0) {
+		return nullptr;
+	}
+	return &entry(handle);
+}
+
+template <size_t H, Size O, Size C>
+typename CompactingAllocator<H, O, C>::Header
+CompactingAllocator<H, O, C>::read_header(Address block) {
+	Header header{};
+	physical().read(&header, block, sizeof(header));
+	return header;
+}
+
+template <size_t H, Size O, Size C>
+void CompactingAllocator<H, O, C>::write_header(Address block,
+												Header header) {
+	physical().write(block, &header, sizeof(header));
+}
+
+template <size_t H, Size O, Size C>
+Address
+CompactingAllocator<H, O, C>::fit(Address from, Address to, Size &size) {
+	Address block = from;
+	while (block < to) {
+		Header header = read_header(block);
+		if (header.handle) {
+			block += header.size;
+			continue;
+		}
+
+		// merge with following free blocks
+		const Size before = header.size;
+		while (block + header.size < to) {
+			const Header next = read_header(block + header.size);
+			if (next.handle) {
+				break;
+			}
+			header.size += next.size;
+		}
+		if (header.size != before) {
+			write_header(block, header);
+		}
+
+		if (header.size >= size) {
+			// split off the remainder if it can hold a header
+			if (header.size - size >= sizeof(Header)) {
+				write_header(block + size, Header{header.size - size, 0});
+			} else {
+				size = header.size;
+			}
+			return block;
+		}
+		block += header.size;
+	}
+	return Address::null();
+}
+
+template <size_t H, Size O, Size C>
+void CompactingAllocator<H, O, C>::finish() {
+	_top = _compacted;
+	_compacted = _scan = _source = _base;
+}
+
+} // namespace allocators
+} // namespace rambock
@@ -0,0 +1,230 @@
+#pragma once
+
+#include "../memory_device.hpp"
+#include "base_allocator.hpp"
+#include <atomic>
+#include <mutex>
+
+namespace rambock {
+namespace allocators {
+
+/** Thread-safe front-end for another allocator
+ * For hosted builds only. Requests are rounded up to one of ClassCount
+ * power-of-two size classes starting at MinBlockSize bytes. Freed blocks are
+ * kept in one of CacheCount caches, each holding up to CacheSize blocks per
+ * class, and every thread is assigned a cache of its own as long as there
+ * are enough of them. Allocating from a cache or freeing into one only takes
+ * that cache's lock, which is uncontended unless threads share a cache.
+ *
+ * The underlying allocator is only called, behind a lock of its own, when a
+ * cache runs empty or full, then half a cache worth of blocks is moved at
+ * once. Requests larger than the largest class always take this path.
+ *
+ * Every block starts with a header holding its class, written once when the
+ * block is first taken from the underlying allocator. Freeing reads it back.
+ * Cached blocks count as free bytes.
+ *
+ * external_ptr and LocalCopy can be used on top from several threads, as
+ * every thread pins its local copies in a table of its own. Copies only alias
+ * copies made on the same thread.
+ * @note The memory device must allow concurrent accesses from several threads
+ */
+template <size_t CacheCount = 8,
+		  size_t ClassCount = 8,
+		  size_t CacheSize = 16,
+		  Size MinBlockSize = 16>
+class ConcurrentAllocator : public BaseAllocator {
+	static_assert(CacheCount > 0 && ClassCount > 0 && CacheSize > 1,
+				  "caches must be able to hold blocks");
+	static_assert(MinBlockSize > 4 && ClassCount < 31,
+				  "classes must hold a header");
+
+	/** Stored in front of every block
+	 * Holds the class index or LARGE for blocks exceeding the largest class.
+	 */
+	using Header = Size;
+	static constexpr Header LARGE = Header(-1);
+
+	struct Cache {
+		std::mutex mutex;
+		Address blocks[ClassCount][CacheSize];
+		size_t counts[ClassCount];
+	};
+
+	static inline Size class_size(size_t index) {
+		return MinBlockSize << index;
+	}
+
+	/** Find the smallest class fitting a block
+	 * @param size block size including header
+	 * @return class index or ClassCount if no class fits
+	 */
+	static size_t class_of(Size size);
+
+	// get the cache of the calling thread
+	Cache &cache();
+
+	// move blocks between a cache and the underlying allocator
+	void refill(Cache &cache, size_t index);
+	void drain(Cache &cache, size_t index);
+
+	BaseAllocator &_allocator;
+	mutable std::mutex _mutex;
+	Cache _caches[CacheCount];
+	// bytes a block of each class takes from the underlying allocator
+	std::atomic<Size> _block_sizes[ClassCount];
+	// bytes in blocks held by caches
+	std::atomic<Size> _cached_bytes;
+
+  public:
+	/** Constructor
+	 * @param allocator the allocator to take blocks from
+	 */
+	explicit ConcurrentAllocator(BaseAllocator &allocator);
+
+	/** Returns all cached blocks to the underlying allocator
+	 */
+	~ConcurrentAllocator() override;
+
+	Address allocate(Size count) override;
+	Size free(Address address) override;
+	Size get_free_bytes() const override;
+};
+
+template <size_t C, size_t N, size_t S, Size M>
+constexpr typename ConcurrentAllocator<C, N, S, M>::Header
+	ConcurrentAllocator<C, N, S, M>::LARGE;
+
+template <size_t C, size_t N, size_t S, Size M>
+ConcurrentAllocator<C, N, S, M>::ConcurrentAllocator(BaseAllocator &allocator)
+	: BaseAllocator(allocator.memory_device())
+	, _allocator{allocator}
+	, _caches{}
+	, _cached_bytes{0} {
+	for (std::atomic<Size> &size : _block_sizes) {
+		size = class_size(&size - _block_sizes);
+	}
+}
+
+template <size_t C, size_t N, size_t S, Size M>
+ConcurrentAllocator<C, N, S, M>::~ConcurrentAllocator() {
+	for (Cache &cache : _caches) {
+		for (size_t index = 0; index < N; index++) {
+			for (size_t i = 0; i < cache.counts[index]; i++) {
+				_allocator.free(cache.blocks[index][i]);
+			}
+		}
+	}
+}
+
+template <size_t C, size_t N, size_t S, Size M>
+Address ConcurrentAllocator<C, N, S, M>::allocate(Size count) {
+	const size_t index = class_of(sizeof(Header) + count);
+	if (index == N) {
+		Address block = Address::null();
+		{
+			std::lock_guard<std::mutex> lock{_mutex};
+			block = _allocator.allocate(sizeof(Header) + count);
+		}
+		if (!block) {
+			return Address::null();
+		}
+		memory_device().write(block, &LARGE, sizeof(LARGE));
+		return block + sizeof(Header);
+	}
+
+	Cache &local = cache();
+	std::lock_guard<std::mutex> lock{local.mutex};
+	if (local.counts[index] == 0) {
+		refill(local, index);
+		if (local.counts[index] == 0) {
+			return Address::null();
+		}
+	}
+	_cached_bytes -= _block_sizes[index];
+	return local.blocks[index][--local.counts[index]] + sizeof(Header);
+}
+
+template <size_t C, size_t N, size_t S, Size M>
+Size ConcurrentAllocator<C, N, S, M>::free(Address address) {
+	if (address.value < sizeof(Header)) {
+		return 0;
+	}
+	const Address block = address - sizeof(Header);
+	Header header{};
+	memory_device().read(&header, block, sizeof(header));
+	if (header == LARGE) {
+		std::lock_guard<std::mutex> lock{_mutex};
+		const Size freed = _allocator.free(block);
+		return freed > sizeof(Header) ? freed - sizeof(Header) : 0;
+	}
+	if (header >= N) {
+		return 0;
+	}
+
+	const size_t index = header;
+	Cache &local = cache();
+	std::lock_guard<std::mutex> lock{local.mutex};
+	if (local.counts[index] == S) {
+		drain(local, index);
+	}
+	local.blocks[index][local.counts[index]++] = block;
+	_cached_bytes += _block_sizes[index];
+	return class_size(index) - sizeof(Header);
+}
+
+template <size_t C, size_t N, size_t S, Size M>
+Size ConcurrentAllocator<C, N, S, M>::get_free_bytes() const {
+	std::lock_guard<std::mutex> lock{_mutex};
+	return _allocator.get_free_bytes() + _cached_bytes;
+}
+
+template <size_t C, size_t N, size_t S, Size M>
+size_t ConcurrentAllocator<C, N, S, M>::class_of(Size size) {
+	for (size_t index = 0; index < N; index++) {
+		if (size <= class_size(index)) {
+			return index;
+		}
+	}
+	return N;
+}
+
+template <size_t C, size_t N, size_t S, Size M>
+typename ConcurrentAllocator<C, N, S, M>::Cache &
+ConcurrentAllocator<C, N, S, M>::cache() {
+	// threads keep their index for all allocators, so caches are shared by
+	// threads once there are more threads than caches
+	static std::atomic<size_t> next_thread{0};
+	static thread_local const size_t thread = next_thread++;
+	return _caches[thread % C];
+}
+
+template <size_t C, size_t N, size_t S, Size M>
+void ConcurrentAllocator<C, N, S, M>::refill(Cache &cache, size_t index) {
+	const Header header = Header(index);
+	std::lock_guard<std::mutex> lock{_mutex};
+	while (cache.counts[index] < S / 2) {
+		// blocks may cost more than their size, account for what is taken
+		const Size before = _allocator.get_free_bytes();
+		const Address block = _allocator.allocate(class_size(index));
+		if (!block) {
+			break;
+		}
+		_block_sizes[index] = before - _allocator.get_free_bytes();
+		memory_device().write(block, &header, sizeof(header));
+		cache.blocks[index][cache.counts[index]++] = block;
+		_cached_bytes += _block_sizes[index];
+	}
+}
+
+template <size_t C, size_t N, size_t S, Size M>
+void ConcurrentAllocator<C, N, S, M>::drain(Cache &cache, size_t index) {
+	std::lock_guard<std::mutex> lock{_mutex};
+	while (cache.counts[index] > S / 2) {
+		_allocator.free(cache.blocks[index][--cache.counts[index]]);
+		_cached_bytes -= _block_sizes[index];
+	}
+}
+
+} // namespace allocators
+} // namespace rambock
@@ -0,0 +1,251 @@
+#pragma once
+
+#include "../memory_device.hpp"
+#include "base_allocator.hpp"
+
+namespace rambock {
+namespace allocators {
+
+/** Allocator with segregated free lists per size class
+ * Blocks are rounded up to one of ClassCount power-of-two size classes
+ * starting at MinBlockSize bytes, header included. Freed blocks are kept as
+ * explicit records in a free list per class whose heads live in local memory,
+ * so allocating costs a single device read when a block of the class is free
+ * and a single write when a new block is carved from untouched memory.
+ * Freeing costs one read and one write.
+ *
+ * If untouched memory runs out, larger free blocks are split in halves.
+ * Blocks larger than the largest class are kept in a separate first-fit list
+ * and do not share the constant cost.
+ */
+template <size_t ClassCount = 8, Size MinBlockSize = 16>
+class SegregatedAllocator : public BaseAllocator {
+	static_assert(ClassCount > 0, "at least one size class is required");
+	static_assert(MinBlockSize >= 8 && MinBlockSize % 4 == 0,
+				  "blocks must hold a header and a free list link");
+
+	/** Stored in front of every block
+	 * Holds the class index, or the block size with LARGE set for blocks
+	 * exceeding the largest class.
+	 */
+	using Header = Size;
+	static constexpr Header LARGE = Header(1) << 31;
+
+	static inline Size class_size(size_t index) {
+		return MinBlockSize << index;
+	}
+
+	/** Find the smallest class fitting a block
+	 * @param size block size including header
+	 * @return class index or ClassCount if no class fits
+	 */
+	static size_t class_of(Size size);
+
+	Header read_header(Address block);
+	void write_header(Address block, Header header);
+	Address read_link(Address block);
+
+	// push a block onto a free list, headers must already be written
+	void push(Address &head, Address block);
+	Address pop(Address &head);
+
+	/** Get a block of a class by splitting a larger free block
+	 * @return block or null if no larger block is free
+	 */
+	Address split(size_t index);
+
+	Address allocate_large(Size size);
+
+	Address _heads[ClassCount];
+	Address _large_head;
+	// never used memory lies between _base and _end
+	Address _base;
+	Address _end;
+	Size _free_bytes;
+
+  public:
+	/** Constructor
+	 * @param end the address just past the last addressable byte
+	 */
+	SegregatedAllocator(MemoryDevice &memory_device, Address end);
+
+	Address allocate(Size count) override;
+	Size free(Address address) override;
+	Size get_free_bytes() const override;
+};
+
+template <size_t N, Size M>
+SegregatedAllocator<N, M>::SegregatedAllocator(MemoryDevice &memory_device,
+											   Address end)
+	: BaseAllocator(memory_device)
+	, _heads{}
+	, _large_head{}
+	// steer clear of NULL
+	, _base{32}
+	, _end{end}
+	, _free_bytes{end > _base ? end - _base : 0} {}
+
+template <size_t N, Size M>
+Address SegregatedAllocator<N, M>::allocate(Size count) {
+	const Size size = sizeof(Header) + 4 * ((count + 4 - 1) / 4);
+	const size_t index = class_of(size);
+	if (index == N) {
+		return allocate_large(size);
+	}
+
+	Address block = pop(_heads[index]);
+	if (!block) {
+		if (_base + class_size(index) <= _end) {
+			// carve from untouched memory
+			block = _base;
+			_base += class_size(index);
+			write_header(block, Header(index));
+		} else {
+			block = split(index);
+		}
+	}
+	if (!block) {
+		return Address::null();
+	}
+	_free_bytes -= class_size(index);
+	return block + sizeof(Header);
+}
+
+template <size_t N, Size M>
+Size SegregatedAllocator<N, M>::free(Address address) {
+	if (address < Address(32) + sizeof(Header) || address >= _end) {
+		return 0;
+	}
+	const Address block = address - sizeof(Header);
+	const Header header = read_header(block);
+	if (header & LARGE) {
+		push(_large_head, block);
+		_free_bytes += header & ~LARGE;
+		return (header & ~LARGE) - sizeof(Header);
+	}
+	if (header >= N) {
+		// not a block of this allocator
+		return 0;
+	}
+	push(_heads[header], block);
+	_free_bytes += class_size(header);
+	return class_size(header) - sizeof(Header);
+}
+
+template <size_t N, Size M>
+Size SegregatedAllocator<N, M>::get_free_bytes() const {
+	return _free_bytes;
+}
+
+template <size_t N, Size M>
+size_t SegregatedAllocator<N, M>::class_of(Size size) {
+	for (size_t index = 0; index < N; index++) {
+		if (size <= class_size(index)) {
+			return index;
+		}
+	}
+	return N;
+}
+
+template <size_t N, Size M>
+typename SegregatedAllocator<N, M>::Header
+SegregatedAllocator<N, M>::read_header(Address block) {
+	Header header{};
+	memory_device().read(&header, block, sizeof(header));
+	return header;
+}
+
+template <size_t N, Size M>
+void SegregatedAllocator<N, M>::write_header(Address block, Header header) {
+	memory_device().write(block, &header, sizeof(header));
+}
+
+template <size_t N, Size M>
+Address SegregatedAllocator<N, M>::read_link(Address block) {
+	Address next{};
+	memory_device().read(
+		&next.value, block + sizeof(Header), sizeof(next.value));
+	return next;
+}
+
+template <size_t N, Size M>
+void SegregatedAllocator<N, M>::push(Address &head, Address block) {
+	// the link lives right behind the header
+	memory_device().write(
+		block + sizeof(Header), &head.value, sizeof(head.value));
+	head = block;
+}
+
+template <size_t N, Size M>
+Address SegregatedAllocator<N, M>::pop(Address &head) {
+	Address block = head;
+	if (block) {
+		head = read_link(block);
+	}
+	return block;
+}
+
+template <size_t N, Size M>
+Address SegregatedAllocator<N, M>::split(size_t index) {
+	// find the smallest larger class with a free block
+	size_t larger = index + 1;
+	while (larger < N && !_heads[larger]) {
+		larger++;
+	}
+	if (larger == N) {
+		return Address::null();
+	}
+
+	// halve the block, keeping the lower half and freeing the upper one
+	Address block = pop(_heads[larger]);
+	while (larger > index) {
+		larger--;
+		Address upper = block + class_size(larger);
+		const Header header = Header(larger);
+		const Address link = _heads[larger];
+		const WriteSegment segments[] = {
+			{upper, &header, sizeof(header)},
+			{upper + sizeof(Header), &link.value, sizeof(link.value)},
+		};
+		memory_device().writev(segments, 2);
+		_heads[larger] = upper;
+	}
+	write_header(block, Header(index));
+	return block;
+}
+
+template <size_t N, Size M>
+Address SegregatedAllocator<N, M>::allocate_large(Size size) {
+	// first fit, large blocks are never split
+	Address previous = Address::null();
+	Address block = _large_head;
+	while (block) {
+		const Header header = read_header(block);
+		const Address next = read_link(block);
+		if ((header & ~LARGE) >= size) {
+			if (previous) {
+				memory_device().write(previous + sizeof(Header),
+									  &next.value,
+									  sizeof(next.value));
+			} else {
+				_large_head = next;
+			}
+			_free_bytes -= header & ~LARGE;
+			return block + sizeof(Header);
+		}
+		previous = block;
+		block = next;
+	}
+
+	if (_base + size > _end) {
+		return Address::null();
+	}
+	block = _base;
+	_base += size;
+	write_header(block, Header(size) | LARGE);
+	_free_bytes -= size;
+	return block + sizeof(Header);
+}
+
+} // namespace allocators
+} // namespace rambock
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "base_allocator.hpp"
+#include <new>
 
 namespace rambock {
 namespace allocators {
@@ -63,22 +64,75 @@ class SimpleAllocator : public BaseAllocator {
 	// setup data structures in memory for allocation
 	void begin();
 
+	/** Local copy of a block's boundaries
+	 * All other header fields follow from the neighboring blocks.
+	 */
+	struct Block {
+		Address address, end;
+	};
+
+	// blocks sorted by address, starting with the head
+	// nullptr unless headers are shadowed
+	Block *_shadow;
+	size_t _shadow_count, _shadow_capacity;
+
+	// reconstruct the header of a shadowed block
+	Header shadow_header(size_t index) const;
+	// find a shadowed block by the address of its data
+	size_t find_shadow(Address begin) const;
+	bool insert_shadow(size_t index, Block block);
+
+	Address allocate_shadowed(Size count);
+	Size free_shadowed(Address address);
+
   public:
-	SimpleAllocator(MemoryDevice &memory_device, Address end);
+	/** Where the allocator looks up block headers
+	 */
+	enum Mode {
+		// read headers from the device on every operation
+		DEVICE_HEADERS,
+		// keep a local index of all blocks, only write headers to the device
+		SHADOW_HEADERS,
+	};
+
+	SimpleAllocator(MemoryDevice &memory_device,
+					Address end,
+					Mode mode = DEVICE_HEADERS);
+	~SimpleAllocator() override;
+	SimpleAllocator(const SimpleAllocator &) = delete;
+	SimpleAllocator &operator=(const SimpleAllocator &) = delete;
 
 	Address allocate(Size count) override;
 	Size free(Address address) override;
 	virtual Size get_free_bytes() const override;
+
+	/** Get local memory used for shadowed headers
+	 * @return Number of bytes, 0 unless headers are shadowed
+	 */
+	inline Size shadow_footprint() const {
+		return _shadow_capacity * sizeof(Block);
+	}
 };
 
-SimpleAllocator::SimpleAllocator(MemoryDevice &memory_device, Address end)
+inline SimpleAllocator::SimpleAllocator(MemoryDevice &memory_device,
+										 Address end,
+										 Mode mode)
 	: BaseAllocator(memory_device)
 	, _end(end)
-	, _free_bytes{end} {
+	, _free_bytes{end}
+	, _shadow{nullptr}
+	, _shadow_count{0}
+	, _shadow_capacity{0} {
 	begin();
+	if (mode == SHADOW_HEADERS) {
+		// the head is an empty block at the very beginning
+		insert_shadow(0, Block{Address(0), Address(0) + sizeof(Header)});
+	}
 }
 
-void SimpleAllocator::begin() {
+inline SimpleAllocator::~SimpleAllocator() { delete[] _shadow; }
+
+inline void SimpleAllocator::begin() {
 	/** Special header to store data about the array
 	 * previous points to itself
 	 * next points to the end of memory
@@ -97,17 +151,20 @@ void SimpleAllocator::begin() {
 	write_header(head.address(), head);
 }
 
-SimpleAllocator::Header SimpleAllocator::read_header(Address from) {
+inline SimpleAllocator::Header SimpleAllocator::read_header(Address from) {
 	Header header;
 	memory_device().read(&header, from, sizeof(header));
 	return header;
 }
 
-void SimpleAllocator::write_header(Address to, Header data) {
+inline void SimpleAllocator::write_header(Address to, Header data) {
 	memory_device().write(to, &data, sizeof(data));
 }
 
-Address SimpleAllocator::allocate(Size count) {
+inline Address SimpleAllocator::allocate(Size count) {
+	if (_shadow) {
+		return allocate_shadowed(count);
+	}
 #define ROUNDUP(c) (4 * (((c) + 4 - 1) / 4))
 	// align to headers
 	Size total_size = sizeof(Header) + ROUNDUP(count);
@@ -137,16 +194,21 @@ Address SimpleAllocator::allocate(Size count) {
 			new_header.previous = current.address();
 			current.next = new_address;
 
-			// write out changes to headers
-			write_header(new_header.address(), new_header);
-			write_header(current.address(), current);
-
+			// write out changes to all headers at once
 			// only touch next if it lies within bounds of memory
+			Header next{};
+			size_t changed = 2;
 			if (new_header.next < end()) {
-				Header next = read_header(new_header.next);
+				next = read_header(new_header.next);
 				next.previous = new_address;
-				write_header(next.address(), next);
+				changed++;
 			}
+			const WriteSegment segments[] = {
+				{new_header.address(), &new_header, sizeof(Header)},
+				{current.address(), &current, sizeof(Header)},
+				{next.address(), &next, sizeof(Header)},
+			};
+			memory_device().writev(segments, changed);
 
 			_free_bytes -= total_size;
 
@@ -162,7 +224,11 @@ Address SimpleAllocator::allocate(Size count) {
 #undef ROUNDUP
 }
 
-Size SimpleAllocator::free(Address address) {
+inline Size SimpleAllocator::free(Address address) {
+	if (_shadow) {
+		return free_shadowed(address);
+	}
+
 	// find the address of this block's header
 	// done this way to let the Header struct decide about its size or optional
 	// padding.
@@ -177,22 +243,153 @@ Size SimpleAllocator::free(Address address) {
 	}
 
 	// unlink from list
-	Header previous = read_header(header.previous);
-	previous.next = header.next;
-	write_header(previous.address(), previous);
-
 	// only touch next if it lies within bounds of memory
-	if (header.next < end()) {
-		Header next = read_header(header.next);
-		next.previous = previous.address();
-		write_header(next.address(), next);
-	}
+	Header previous{}, next{};
+	const size_t neighbors = header.next < end() ? 2 : 1;
+	const ReadSegment reads[] = {
+		{&previous, header.previous, sizeof(Header)},
+		{&next, header.next, sizeof(Header)},
+	};
+	memory_device().readv(reads, neighbors);
+
+	previous.next = header.next;
+	next.previous = previous.address();
+	const WriteSegment writes[] = {
+		{previous.address(), &previous, sizeof(Header)},
+		{next.address(), &next, sizeof(Header)},
+	};
+	memory_device().writev(writes, neighbors);
 
 	_free_bytes += header.size() + sizeof(header);
 	return header.size();
 }
 
-Size SimpleAllocator::get_free_bytes() const { return _free_bytes; }
+inline Size SimpleAllocator::get_free_bytes() const { return _free_bytes; }
+
+inline SimpleAllocator::Header
+SimpleAllocator::shadow_header(size_t index) const {
+	Header header{};
+	header.set_address(_shadow[index].address);
+	header.end = _shadow[index].end;
+	// the head points to itself
+	header.previous = _shadow[index ? index - 1 : 0].address;
+	header.next =
+		index + 1 < _shadow_count ? _shadow[index + 1].address : end();
+	return header;
+}
+
+inline size_t SimpleAllocator::find_shadow(Address begin) const {
+	Header header{};
+	header.begin = begin;
+	const Address address = header.address();
+
+	// binary search, returns _shadow_count if there is no such block
+	size_t low = 0, high = _shadow_count;
+	while (low < high) {
+		size_t middle = low + (high - low) / 2;
+		if (_shadow[middle].address < address) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	if (low < _shadow_count && _shadow[low].address == address) {
+		return low;
+	}
+	return _shadow_count;
+}
+
+inline bool SimpleAllocator::insert_shadow(size_t index, Block block) {
+	if (_shadow_count == _shadow_capacity) {
+		size_t capacity = _shadow_capacity ? 2 * _shadow_capacity : 8;
+		Block *shadow = new (std::nothrow) Block[capacity];
+		if (!shadow) {
+			return false;
+		}
+		for (size_t i = 0; i < _shadow_count; i++) {
+			shadow[i] = _shadow[i];
+		}
+		delete[] _shadow;
+		_shadow = shadow;
+		_shadow_capacity = capacity;
+	}
+	for (size_t i = _shadow_count; i > index; i--) {
+		_shadow[i] = _shadow[i - 1];
+	}
+	_shadow[index] = block;
+	_shadow_count++;
+	return true;
+}
+
+inline Address SimpleAllocator::allocate_shadowed(Size count) {
+#define ROUNDUP(c) (4 * (((c) + 4 - 1) / 4))
+	Size total_size = sizeof(Header) + ROUNDUP(count);
+
+	// same first fit as allocate(), but looking at the local index only
+	for (size_t i = 0; i < _shadow_count; i++) {
+		const Address end_address = Address(ROUNDUP(_shadow[i].end.value));
+		const Address next =
+			i + 1 < _shadow_count ? _shadow[i + 1].address : end();
+		if (next < end_address || total_size > next - end_address) {
+			continue;
+		}
+
+		Header new_header{};
+		new_header.set_address(end_address);
+		new_header.set_size(count);
+		if (!insert_shadow(i + 1, Block{end_address, new_header.end})) {
+			return Address::null();
+		}
+
+		// write out all changed headers at once
+		// only touch next if it lies within bounds of memory
+		Header headers[] = {
+			shadow_header(i),
+			shadow_header(i + 1),
+			i + 2 < _shadow_count ? shadow_header(i + 2) : Header{},
+		};
+		const WriteSegment segments[] = {
+			{headers[0].address(), &headers[0], sizeof(Header)},
+			{headers[1].address(), &headers[1], sizeof(Header)},
+			{headers[2].address(), &headers[2], sizeof(Header)},
+		};
+		memory_device().writev(segments, i + 2 < _shadow_count ? 3 : 2);
+
+		_free_bytes -= total_size;
+		return new_header.begin;
+	}
+	return Address::null();
+#undef ROUNDUP
+}
+
+inline Size SimpleAllocator::free_shadowed(Address address) {
+	const size_t index = find_shadow(address);
+	// never free the head or unknown blocks
+	if (index == 0 || index == _shadow_count) {
+		return 0;
+	}
+
+	const Block block = _shadow[index];
+	for (size_t i = index + 1; i < _shadow_count; i++) {
+		_shadow[i - 1] = _shadow[i];
+	}
+	_shadow_count--;
+
+	// unlink from list, neighbors are now adjacent in the index
+	Header headers[] = {
+		shadow_header(index - 1),
+		index < _shadow_count ? shadow_header(index) : Header{},
+	};
+	const WriteSegment segments[] = {
+		{headers[0].address(), &headers[0], sizeof(Header)},
+		{headers[1].address(), &headers[1], sizeof(Header)},
+	};
+	memory_device().writev(segments, index < _shadow_count ? 2 : 1);
+
+	const Size size = block.end - (block.address + sizeof(Header));
+	_free_bytes += size + sizeof(Header);
+	return size;
+}
 
 } // namespace allocators
 } // namespace rambock
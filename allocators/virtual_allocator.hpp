@@ -0,0 +1,723 @@
+#pragma once
+
+#include "../memory_device.hpp"
+#include "base_allocator.hpp"
+#include <memory.h>
+#include <stddef.h>
+
+namespace rambock {
+namespace allocators {
+
+/** Virtual Memory Allocator
+ * Hands out addresses in a virtual address space of 2^AddressBits bytes, which
+ * may be far larger than the physical device. The virtual space is divided
+ * into pages of PageSize bytes that are only backed by a physical frame once
+ * they are written to. Reading a page that was never written yields zeros.
+ *
+ * Translations are stored in a multi-level page table on the physical device,
+ * with the root table in the first frame. Each table entry holds the address
+ * of the next table or data frame. In the last level, the bits below PageSize
+ * count the allocations and free extents sharing a page, so the page can be
+ * released once the last of them is gone. In the levels above, they count the
+ * used entries of the next table, which is released once none are left. The
+ * most recent translations are kept in a local TLB, so accesses only walk the
+ * page table on a TLB miss.
+ *
+ * Freed ranges are merged with adjacent free ones and kept in a list ordered
+ * by address, which allocations search first fit before taking fresh virtual
+ * space. A free range only keeps its first and last page mapped.
+ *
+ * The allocator is also the MemoryDevice that translates virtual addresses,
+ * memory_device() returns it for use with external_ptr and layers.
+ */
+template <Size PageSize, size_t TLBSize = 8, Size AddressBits = 32>
+class VirtualAllocator : public MemoryDevice, public BaseAllocator {
+	static constexpr Size log2(Size n) { return n <= 1 ? 0 : 1 + log2(n / 2); }
+
+	using Entry = uint32_t;
+
+	static_assert(PageSize >= 32 && (PageSize & (PageSize - 1)) == 0,
+				  "PageSize must be a power of two of at least 32 bytes");
+	static_assert(TLBSize > 0, "TLB must hold at least one translation");
+	static_assert(AddressBits <= 32 && AddressBits > log2(PageSize),
+				  "AddressBits must fit into Address and exceed a page");
+
+	static constexpr Size OFFSET_BITS = log2(PageSize);
+	static constexpr Size INDEX_BITS = log2(PageSize / sizeof(Entry));
+	static constexpr Size PAGE_BITS = AddressBits - OFFSET_BITS;
+	static constexpr Size LEVELS = (PAGE_BITS + INDEX_BITS - 1) / INDEX_BITS;
+	// low entry bits are free because frames are aligned to pages
+	static constexpr Entry COUNT_MASK = PageSize - 1;
+	// every allocation is preceded by its size, including the header
+	static constexpr Size HEADER_SIZE = sizeof(Size);
+	// set in the size of a free extent, headers of freed allocations are zero
+	static constexpr Size FREE = Size(1) << 31;
+
+	// starts every range in the list of free virtual ranges
+	struct Extent {
+		Size size;
+		Address next;
+	};
+
+	// pages counting a few allocations or extents, their first and last page
+	struct Holds {
+		uint32_t pages[6];
+		size_t count;
+
+		void add(uint64_t begin, uint64_t end);
+		bool remove(uint32_t page);
+	};
+
+	struct TLBEntry {
+		uint32_t page;
+		Address frame;
+		uint32_t last_use;
+		bool valid;
+	};
+
+	MemoryDevice &_physical;
+	inline MemoryDevice &physical() const { return _physical; }
+
+	Address _physical_end;
+	// never used frames start here, freed frames form a list on the device
+	Address _unused_frames;
+	Address _free_frames;
+	Size _free_frame_count;
+	// next unallocated virtual address
+	uint64_t _next;
+	// first free extent below _next
+	Address _free_extents;
+
+	TLBEntry _tlb[TLBSize];
+	uint32_t _clock;
+	uint32_t _tlb_hits, _tlb_misses;
+
+	static inline uint32_t page_of(uint64_t address) {
+		return uint32_t(address >> OFFSET_BITS);
+	}
+	static inline Address frame_of(Entry entry) {
+		return Address(entry & ~COUNT_MASK);
+	}
+
+	Address allocate_frame();
+	void free_frame(Address frame);
+	void clear_frame(Address frame);
+
+	/** Find the page table entry for a page
+	 * @param page virtual page number
+	 * @param create whether missing tables are created
+	 * @param entry set to the physical address of the entry
+	 * @param span set to the number of pages without tables if none was found
+	 * @param path set to the entries on the way if not nullptr
+	 * @return true if the entry exists
+	 */
+	bool walk(uint32_t page,
+			  bool create,
+			  Address &entry,
+			  uint32_t &span,
+			  Address *path = nullptr);
+
+	/** Count an entry of the last level becoming used or unused
+	 * Tables left without used entries are released.
+	 */
+	void count_entry(uint32_t page, bool used);
+
+	/** Translate a virtual page to its physical frame
+	 * @param page virtual page number
+	 * @param map whether an unmapped page is mapped to a new frame
+	 * @return physical frame or null if the page is not mapped
+	 */
+	Address translate(uint32_t page, bool map);
+
+	TLBEntry *lookup(uint32_t page);
+	void remember(uint32_t page, Address frame);
+	void forget(uint32_t page);
+
+	// count an allocation sharing a page, fails if the count is saturated
+	bool retain(uint32_t page);
+	// remove an allocation from a page, unmap the page if none remain
+	void release(uint32_t page);
+	void unmap(uint32_t page);
+	// unmap the pages a range covers without sharing them
+	void unmap_inner(uint64_t begin, uint64_t end);
+
+	/** Move the page counts of some objects to others covering the same range
+	 * @return false if a page is shared too often, nothing changed then
+	 */
+	bool exchange(Holds before, Holds after);
+	// allocate from the front of a free extent, previous is the one before
+	Address
+	take(Address previous, Address extent, const Extent &node, Size size);
+	// let the successor of a free extent, or the first one if null, be next
+	void link(Address extent, Address next);
+
+  public:
+	/** Constructor
+	 * @param physical the device to store pages and page tables on
+	 * @param physical_end the address just past the last physical byte
+	 */
+	VirtualAllocator(MemoryDevice &physical, Address physical_end);
+
+	Address allocate(Size count) override;
+	Size free(Address address) override;
+
+	/** Get number of physical bytes not backing any page yet
+	 * @note Virtual allocations only fail once the address space is exhausted
+	 * @return Number of unused physical bytes
+	 */
+	Size get_free_bytes() const override;
+
+	/** Reads from virtual memory, unmapped pages read as zeros
+	 */
+	void *read(void *to, Address from, Size count) override;
+
+	/** Writes to virtual memory, mapping pages as needed
+	 * @return null if no physical frame was left to map a page
+	 */
+	Address write(Address to, const void *from, Size count) override;
+
+	inline uint32_t tlb_hits() const { return _tlb_hits; }
+	inline uint32_t tlb_misses() const { return _tlb_misses; }
+};
+
+template <Size P, size_t T, Size B>
+constexpr Size VirtualAllocator<P, T, B>::HEADER_SIZE;
+template <Size P, size_t T, Size B>
+constexpr Size VirtualAllocator<P, T, B>::FREE;
+
+template <Size P, size_t T, Size B>
+VirtualAllocator<P, T, B>::VirtualAllocator(MemoryDevice &physical,
+											Address physical_end)
+	: MemoryDevice{}
+	, BaseAllocator(static_cast<MemoryDevice &>(*this))
+	, _physical{physical}
+	, _physical_end{physical_end.value - physical_end.value % P}
+	, _unused_frames{P}
+	, _free_frames{}
+	, _free_frame_count{0}
+	// steer clear of NULL
+	, _next{P}
+	, _free_extents{}
+	, _tlb{}
+	, _clock{0}
+	, _tlb_hits{0}
+	, _tlb_misses{0} {
+	// root table occupies the first frame
+	clear_frame(Address::null());
+}
+
+template <Size P, size_t T, Size B>
+Address VirtualAllocator<P, T, B>::allocate(Size count) {
+	// keep allocations aligned to extents, so the Extent written once freed
+	// does not cross a page
+#define ROUNDUP(c, n) ((n) * (((c) + (n) - 1) / (n)))
+	const uint64_t total_size =
+		ROUNDUP(uint64_t(HEADER_SIZE) + count, sizeof(Extent));
+#undef ROUNDUP
+	if (total_size >= FREE) {
+		return Address::null();
+	}
+
+	Address previous = Address::null();
+	for (Address extent = _free_extents; extent;) {
+		Extent node{};
+		read(&node, extent, sizeof(node));
+		if ((node.size & ~FREE) >= total_size) {
+			Address address = take(previous, extent, node, Size(total_size));
+			if (address) {
+				return address;
+			}
+		}
+		previous = extent;
+		extent = node.next;
+	}
+
+	uint64_t begin = _next;
+	if (begin + total_size > (uint64_t(1) << B)) {
+		return Address::null();
+	}
+
+	// the first page may be shared with previous allocations
+	if (!retain(page_of(begin))) {
+		// too many allocations share the page, start on a fresh one
+		begin = (begin + P - 1) & ~uint64_t(P - 1);
+		if (begin + total_size > (uint64_t(1) << B) ||
+			!retain(page_of(begin))) {
+			return Address::null();
+		}
+	}
+	const uint64_t end = begin + total_size;
+	if (page_of(end - 1) != page_of(begin) && !retain(page_of(end - 1))) {
+		release(page_of(begin));
+		return Address::null();
+	}
+
+	Address header = Address(uint32_t(begin));
+	const Size size = Size(total_size);
+	if (!write(header, &size, sizeof(size))) {
+		release(page_of(begin));
+		if (page_of(end - 1) != page_of(begin)) {
+			release(page_of(end - 1));
+		}
+		return Address::null();
+	}
+	_next = end;
+	return header + HEADER_SIZE;
+}
+
+template <Size P, size_t T, Size B>
+Size VirtualAllocator<P, T, B>::free(Address address) {
+	if (address.value < P + HEADER_SIZE || address.value >= _next) {
+		return 0;
+	}
+	const Address header = address - HEADER_SIZE;
+	Size size = 0;
+	read(&size, header, sizeof(size));
+	if (size < sizeof(Extent) || (size & FREE) ||
+		header.value + uint64_t(size) > _next) {
+		// already free or not an allocation
+		return 0;
+	}
+	// clear the header while its page is mapped, so freeing again is caught
+	const Size cleared = 0;
+	write(header, &cleared, sizeof(cleared));
+
+	uint64_t begin = header.value, end = begin + size;
+	unmap_inner(begin, end);
+	Holds before{}, after{};
+	before.add(begin, end);
+
+	// find the free extents around the allocation
+	Address second = Address::null(), previous = Address::null();
+	Address next = _free_extents;
+	Extent node{};
+	while (next && next < header) {
+		second = previous;
+		previous = next;
+		read(&node, previous, sizeof(node));
+		next = node.next;
+	}
+
+	// merge with adjacent ones
+	if (previous && previous.value + (node.size & ~FREE) == begin) {
+		before.add(previous.value, begin);
+		begin = previous.value;
+		previous = second;
+	}
+	if (next && next.value == end) {
+		read(&node, next, sizeof(node));
+		before.add(end, end + (node.size & ~FREE));
+		end += node.size & ~FREE;
+		next = node.next;
+	}
+
+	if (end == _next) {
+		// nothing follows, return the range to fresh virtual space
+		_next = begin;
+		link(previous, Address::null());
+	} else {
+		const Address extent = Address(uint32_t(begin));
+		node = Extent{Size(end - begin) | FREE, next};
+		write(extent, &node, sizeof(node));
+		link(previous, extent);
+		after.add(begin, end);
+	}
+	// only releases pages, so it cannot fail
+	exchange(before, after);
+	return size - HEADER_SIZE;
+}
+
+template <Size P, size_t T, Size B>
+Size VirtualAllocator<P, T, B>::get_free_bytes() const {
+	return _free_frame_count * P + (_physical_end - _unused_frames);
+}
+
+template <Size P, size_t T, Size B>
+void *VirtualAllocator<P, T, B>::read(void *to, Address from, Size count) {
+	uint8_t *data = static_cast<uint8_t *>(to);
+	uint64_t address = from.value;
+	Size remaining = count;
+	while (remaining > 0) {
+		const Size offset = Size(address % P);
+		const Size chunk = P - offset < remaining ? P - offset : remaining;
+
+		Address frame = translate(page_of(address), false);
+		if (frame) {
+			physical().read(data, frame + offset, chunk);
+		} else {
+			memset(data, 0, chunk);
+		}
+
+		data += chunk;
+		address += chunk;
+		remaining -= chunk;
+	}
+	return to;
+}
+
+template <Size P, size_t T, Size B>
+Address
+VirtualAllocator<P, T, B>::write(Address to, const void *from, Size count) {
+	const uint8_t *data = static_cast<const uint8_t *>(from);
+	uint64_t address = to.value;
+	Size remaining = count;
+	while (remaining > 0) {
+		const Size offset = Size(address % P);
+		const Size chunk = P - offset < remaining ? P - offset : remaining;
+
+		Address frame = translate(page_of(address), true);
+		if (!frame) {
+			return Address::null();
+		}
+		physical().write(frame + offset, data, chunk);
+
+		data += chunk;
+		address += chunk;
+		remaining -= chunk;
+	}
+	return to;
+}
+
+template <Size P, size_t T, Size B>
+Address VirtualAllocator<P, T, B>::allocate_frame() {
+	Address frame = Address::null();
+	if (_free_frames) {
+		frame = _free_frames;
+		physical().read(&_free_frames.value, frame, sizeof(_free_frames.value));
+		_free_frame_count--;
+	} else if (_unused_frames + P <= _physical_end) {
+		frame = _unused_frames;
+		_unused_frames += P;
+	}
+	return frame;
+}
+
+template <Size P, size_t T, Size B>
+void VirtualAllocator<P, T, B>::free_frame(Address frame) {
+	physical().write(frame, &_free_frames.value, sizeof(_free_frames.value));
+	_free_frames = frame;
+	_free_frame_count++;
+}
+
+template <Size P, size_t T, Size B>
+void VirtualAllocator<P, T, B>::clear_frame(Address frame) {
+	const uint8_t zeros[32] = {};
+	for (Size offset = 0; offset < P; offset += sizeof(zeros)) {
+		physical().write(frame + offset, zeros, sizeof(zeros));
+	}
+}
+
+template <Size P, size_t T, Size B>
+bool VirtualAllocator<P, T, B>::walk(uint32_t page,
+									 bool create,
+									 Address &entry,
+									 uint32_t &span,
+									 Address *path) {
+	Address table = Address::null();
+	Address parent = Address::null();
+	for (Size level = 0; level < LEVELS; level++) {
+		const Size shift = (LEVELS - 1 - level) * INDEX_BITS;
+		const uint32_t index = (page >> shift) & ((1 << INDEX_BITS) - 1);
+		entry = table + index * sizeof(Entry);
+		if (path) {
+			path[level] = entry;
+		}
+		if (level == LEVELS - 1) {
+			return true;
+		}
+
+		Entry value = 0;
+		physical().read(&value, entry, sizeof(value));
+		if (!frame_of(value)) {
+			if (!create) {
+				span = uint32_t(1) << shift;
+				return false;
+			}
+			Address next = allocate_frame();
+			if (!next) {
+				span = uint32_t(1) << shift;
+				return false;
+			}
+			clear_frame(next);
+			value = next.value;
+			physical().write(entry, &value, sizeof(value));
+			if (level > 0) {
+				// the table holding the entry has one more in use
+				Entry count = 0;
+				physical().read(&count, parent, sizeof(count));
+				count++;
+				physical().write(parent, &count, sizeof(count));
+			}
+		}
+		parent = entry;
+		table = frame_of(value);
+	}
+	return true;
+}
+
+template <Size P, size_t T, Size B>
+void VirtualAllocator<P, T, B>::count_entry(uint32_t page, bool used) {
+	Address path[LEVELS];
+	uint32_t span = 1;
+	if (!walk(page, false, path[LEVELS - 1], span, path)) {
+		return;
+	}
+	// the entry at level changed, the one above counts used entries of its
+	// table
+	for (Size level = LEVELS - 1; level > 0; level--) {
+		Entry value = 0;
+		physical().read(&value, path[level - 1], sizeof(value));
+		if (used) {
+			value++;
+			physical().write(path[level - 1], &value, sizeof(value));
+			return;
+		}
+		value--;
+		if (value & COUNT_MASK) {
+			physical().write(path[level - 1], &value, sizeof(value));
+			return;
+		}
+		free_frame(frame_of(value));
+		value = 0;
+		physical().write(path[level - 1], &value, sizeof(value));
+	}
+}
+
+template <Size P, size_t T, Size B>
+Address VirtualAllocator<P, T, B>::translate(uint32_t page, bool map) {
+	TLBEntry *cached = lookup(page);
+	if (cached) {
+		_tlb_hits++;
+		return cached->frame;
+	}
+	_tlb_misses++;
+
+	Address entry;
+	uint32_t span = 1;
+	if (!walk(page, map, entry, span)) {
+		return Address::null();
+	}
+	Entry value = 0;
+	physical().read(&value, entry, sizeof(value));
+	Address frame = frame_of(value);
+	if (!frame) {
+		if (!map) {
+			return Address::null();
+		}
+		frame = allocate_frame();
+		if (!frame) {
+			return Address::null();
+		}
+		const Entry count = value & COUNT_MASK;
+		value = frame.value | count;
+		physical().write(entry, &value, sizeof(value));
+		if (!count) {
+			count_entry(page, true);
+		}
+	}
+	remember(page, frame);
+	return frame;
+}
+
+template <Size P, size_t T, Size B>
+typename VirtualAllocator<P, T, B>::TLBEntry *
+VirtualAllocator<P, T, B>::lookup(uint32_t page) {
+	for (TLBEntry &entry : _tlb) {
+		if (entry.valid && entry.page == page) {
+			entry.last_use = ++_clock;
+			return &entry;
+		}
+	}
+	return nullptr;
+}
+
+template <Size P, size_t T, Size B>
+void VirtualAllocator<P, T, B>::remember(uint32_t page, Address frame) {
+	// replace an empty or the least recently used entry
+	TLBEntry *victim = &_tlb[0];
+	for (TLBEntry &entry : _tlb) {
+		if (!entry.valid) {
+			victim = &entry;
+			break;
+		}
+		if (entry.last_use < victim->last_use) {
+			victim = &entry;
+		}
+	}
+	*victim = TLBEntry{page, frame, ++_clock, true};
+}
+
+template <Size P, size_t T, Size B>
+void VirtualAllocator<P, T, B>::forget(uint32_t page) {
+	TLBEntry *entry = lookup(page);
+	if (entry) {
+		entry->valid = false;
+	}
+}
+
+template <Size P, size_t T, Size B>
+bool VirtualAllocator<P, T, B>::retain(uint32_t page) {
+	Address entry;
+	uint32_t span = 1;
+	if (!walk(page, true, entry, span)) {
+		return false;
+	}
+	Entry value = 0;
+	physical().read(&value, entry, sizeof(value));
+	if ((value & COUNT_MASK) == COUNT_MASK) {
+		return false;
+	}
+	value++;
+	physical().write(entry, &value, sizeof(value));
+	if (value == 1) {
+		count_entry(page, true);
+	}
+	return true;
+}
+
+template <Size P, size_t T, Size B>
+void VirtualAllocator<P, T, B>::release(uint32_t page) {
+	Address entry;
+	uint32_t span = 1;
+	if (!walk(page, false, entry, span)) {
+		return;
+	}
+	Entry value = 0;
+	physical().read(&value, entry, sizeof(value));
+	if ((value & COUNT_MASK) > 1) {
+		value--;
+		physical().write(entry, &value, sizeof(value));
+	} else {
+		unmap(page);
+	}
+}
+
+template <Size P, size_t T, Size B>
+void VirtualAllocator<P, T, B>::unmap(uint32_t page) {
+	Address entry;
+	uint32_t span = 1;
+	if (!walk(page, false, entry, span)) {
+		return;
+	}
+	Entry value = 0;
+	physical().read(&value, entry, sizeof(value));
+	if (!value) {
+		return;
+	}
+	if (frame_of(value)) {
+		free_frame(frame_of(value));
+	}
+	value = 0;
+	physical().write(entry, &value, sizeof(value));
+	forget(page);
+	count_entry(page, false);
+}
+
+template <Size P, size_t T, Size B>
+void VirtualAllocator<P, T, B>::unmap_inner(uint64_t begin, uint64_t end) {
+	const uint32_t last = page_of(end - 1);
+	uint32_t page = page_of(begin) + 1;
+	while (page < last) {
+		Address entry;
+		uint32_t span = 1;
+		if (walk(page, false, entry, span)) {
+			unmap(page);
+		} else {
+			// skip pages without any table
+			page = (page | (span - 1)) + 1;
+			continue;
+		}
+		page++;
+	}
+}
+
+template <Size P, size_t T, Size B>
+void VirtualAllocator<P, T, B>::Holds::add(uint64_t begin, uint64_t end) {
+	pages[count++] = page_of(begin);
+	if (page_of(end - 1) != page_of(begin)) {
+		pages[count++] = page_of(end - 1);
+	}
+}
+
+template <Size P, size_t T, Size B>
+bool VirtualAllocator<P, T, B>::Holds::remove(uint32_t page) {
+	for (size_t i = 0; i < count; i++) {
+		if (pages[i] == page) {
+			pages[i] = pages[--count];
+			return true;
+		}
+	}
+	return false;
+}
+
+template <Size P, size_t T, Size B>
+bool VirtualAllocator<P, T, B>::exchange(Holds before, Holds after) {
+	// retain first, so pages counted by both stay mapped
+	Holds retained{};
+	for (size_t i = 0; i < after.count; i++) {
+		const uint32_t page = after.pages[i];
+		if (before.remove(page)) {
+			continue;
+		}
+		if (!retain(page)) {
+			for (size_t j = 0; j < retained.count; j++) {
+				release(retained.pages[j]);
+			}
+			return false;
+		}
+		retained.pages[retained.count++] = page;
+	}
+	for (size_t i = 0; i < before.count; i++) {
+		release(before.pages[i]);
+	}
+	return true;
+}
+
+template <Size P, size_t T, Size B>
+Address VirtualAllocator<P, T, B>::take(Address previous,
+										Address extent,
+										const Extent &node,
+										Size size) {
+	const uint64_t begin = extent.value;
+	const uint64_t end = begin + (node.size & ~FREE);
+	if (end - begin - size < sizeof(Extent)) {
+		// the rest could not be freed on its own, hand it out as well
+		size = Size(end - begin);
+	}
+	const uint64_t split = begin + size;
+	Holds before{}, after{};
+	before.add(begin, end);
+	after.add(begin, split);
+	if (split < end) {
+		after.add(split, end);
+	}
+	if (!exchange(before, after)) {
+		return Address::null();
+	}
+
+	Address next = node.next;
+	if (split < end) {
+		const Address rest = Address(uint32_t(split));
+		const Extent remainder{Size(end - split) | FREE, node.next};
+		if (!write(rest, &remainder, sizeof(remainder))) {
+			exchange(after, before);
+			return Address::null();
+		}
+		next = rest;
+	}
+	link(previous, next);
+	write(extent, &size, sizeof(size));
+	return extent + HEADER_SIZE;
+}
+
+template <Size P, size_t T, Size B>
+void VirtualAllocator<P, T, B>::link(Address extent, Address next) {
+	if (!extent) {
+		_free_extents = next;
+		return;
+	}
+	write(extent + offsetof(Extent, next), &next, sizeof(next));
+}
+
+} // namespace allocators
+} // namespace rambock
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "memory_device.hpp"
+
+namespace rambock {
+
+/** Abstract asynchronous Memory Device
+ * Transfers are submitted and complete later, identified by a request handle.
+ * Completion can be polled, waited for or signalled through a callback.
+ * Local storage passed to a request must stay valid until it completed.
+ *
+ * Synchronous read/write submit a request and wait for it, so asynchronous
+ * devices can be used wherever a MemoryDevice is expected.
+ */
+struct AsyncMemoryDevice : public MemoryDevice {
+	/** Handle of a submitted request, never zero
+	 */
+	using Request = uint32_t;
+
+	/** Called once a request completed
+	 * @param context the context passed on submission
+	 */
+	using Callback = void (*)(void *context);
+
+	/** Submits a read from a device into local storage
+	 * @param to the address to copy the data to
+	 * @param from the address to read from
+	 * @param n the number of bytes to read
+	 * @param callback called on completion, may be nullptr
+	 * @param context passed to callback
+	 * @return handle of the request
+	 */
+	virtual Request submit_read(
+		void *to, Address from, Size n, Callback callback, void *context) = 0;
+
+	/** Submits a write to a device from local storage
+	 * @param to the address to write to
+	 * @param from the address to copy the data from
+	 * @param n the number of bytes to write
+	 * @param callback called on completion, may be nullptr
+	 * @param context passed to callback
+	 * @return handle of the request
+	 */
+	virtual Request submit_write(Address to,
+								 const void *from,
+								 Size n,
+								 Callback callback,
+								 void *context) = 0;
+
+	/** Checks whether a request completed
+	 * @param request handle returned on submission
+	 * @return true if the request completed
+	 */
+	virtual bool poll(Request request) = 0;
+
+	/** Blocks until a request completed
+	 * @param request handle returned on submission
+	 */
+	virtual void wait(Request request) = 0;
+
+	void *read(void *to, Address from, Size n) override {
+		wait(submit_read(to, from, n, nullptr, nullptr));
+		return to;
+	}
+
+	Address write(Address to, const void *from, Size n) override {
+		wait(submit_write(to, from, n, nullptr, nullptr));
+		return to;
+	}
+};
+
+/** Asynchronous interface for a synchronous device
+ * Executes every request on submission, so all requests are complete by the
+ * time their handle is returned. Useful where no threads are available.
+ */
+struct BlockingAsyncDevice : public AsyncMemoryDevice {
+	explicit BlockingAsyncDevice(MemoryDevice &memory_device)
+		: _memory_device{memory_device}
+		, _next{0} {}
+
+	Request submit_read(void *to,
+						Address from,
+						Size n,
+						Callback callback,
+						void *context) override {
+		_memory_device.read(to, from, n);
+		return complete(callback, context);
+	}
+
+	Request submit_write(Address to,
+						 const void *from,
+						 Size n,
+						 Callback callback,
+						 void *context) override {
+		_memory_device.write(to, from, n);
+		return complete(callback, context);
+	}
+
+	bool poll(Request) override { return true; }
+	void wait(Request) override {}
+
+  private:
+	inline Request complete(Callback callback, void *context) {
+		if (callback) {
+			callback(context);
+		}
+		// skip zero on overflow
+		return ++_next ? _next : ++_next;
+	}
+
+	MemoryDevice &_memory_device;
+	Request _next;
+};
+
+} // namespace rambock
@@ -0,0 +1,76 @@
+#include "../allocators/buddy_allocator.hpp"
+#include "../allocators/bump_allocator.hpp"
+#include "../allocators/segregated_allocator.hpp"
+#include "../allocators/simple_allocator.hpp"
+#include "../layers/access_counter.hpp"
+#include "../mocks/mock_memory_device.hpp"
+#include <catch2/catch_all.hpp>
+#include <iostream>
+
+using namespace rambock;
+using namespace allocators;
+using namespace layers;
+using namespace mocks;
+
+TEST_CASE("benchmark allocators", "[benchmarks]") {
+	constexpr Size memory_size = 64 * 1024;
+	constexpr Size object_size = 24;
+	constexpr Size live_counts[] = {10, 100, 1000};
+	constexpr Size rounds = 100;
+	static MockMemoryDevice<memory_size> memory_device{};
+
+	// Keep n objects alive, then repeatedly free one and allocate another
+	auto churn = [&](BaseAllocator &allocator,
+					 AccessCounter &counter,
+					 Size n) {
+		Address addresses[1000];
+		for (Size i = 0; i < n; i++) {
+			addresses[i] = allocator.allocate(object_size);
+		}
+
+		counter.reset();
+		for (Size i = 0; i < rounds; i++) {
+			Size victim = (i * 7) % n;
+			allocator.free(addresses[victim]);
+			addresses[victim] = allocator.allocate(object_size);
+			REQUIRE(addresses[victim]);
+		}
+		return double(counter.reads() + counter.writes()) / rounds;
+	};
+
+	for (Size n : live_counts) {
+		AccessCounter bump_counter{memory_device};
+		BumpAllocator bump{bump_counter, Address(memory_size)};
+		double bump_cost = churn(bump, bump_counter, n);
+
+		AccessCounter simple_counter{memory_device};
+		SimpleAllocator simple{simple_counter, Address(memory_size)};
+		double simple_cost = churn(simple, simple_counter, n);
+
+		AccessCounter shadow_counter{memory_device};
+		SimpleAllocator shadow{shadow_counter,
+							   Address(memory_size),
+							   SimpleAllocator::SHADOW_HEADERS};
+		double shadow_cost = churn(shadow, shadow_counter, n);
+
+		AccessCounter segregated_counter{memory_device};
+		SegregatedAllocator<> segregated{segregated_counter,
+										 Address(memory_size)};
+		double segregated_cost = churn(segregated, segregated_counter, n);
+
+		AccessCounter buddy_counter{memory_device};
+		BuddyAllocator<> buddy{buddy_counter, Address(memory_size)};
+		double buddy_cost = churn(buddy, buddy_counter, n);
+
+		std::cout << n << " live objects, transactions per free+allocate: "
+				  << "bump " << bump_cost << ", simple " << simple_cost
+				  << ", shadowed simple " << shadow_cost << " ("
+				  << shadow.shadow_footprint() << " bytes local)"
+				  << ", segregated " << segregated_cost << ", buddy "
+				  << buddy_cost << "\n";
+
+		REQUIRE(segregated_cost <= 3);
+		REQUIRE(segregated_cost <= simple_cost);
+		REQUIRE(shadow_cost <= 2);
+	}
+}
@@ -0,0 +1,68 @@
+#include "../layers/access_counter.hpp"
+#include "../layers/cache_layer.hpp"
+#include "../layers/lru_cache_layer.hpp"
+#include "../mocks/mock_memory_device.hpp"
+#include "../mocks/mock_slow_layer.hpp"
+#include <catch2/catch_all.hpp>
+#include <iostream>
+
+using namespace rambock;
+using namespace mocks;
+using namespace layers;
+
+TEST_CASE("benchmark lru cache", "[benchmarks]") {
+	using Data = int;
+	constexpr Size memory_size = 4096;
+	constexpr Size cache_size = 64;
+	constexpr Size line_size = 16;
+	constexpr Size N = 256;
+	// Two regions far apart, e.g. list nodes and allocator headers
+	const Address first_region = Address{0};
+	const Address second_region = Address{memory_size / 2};
+
+	MockMemoryDevice<memory_size> memory_device{};
+	MockSlowLayer<1> slow_layer{memory_device};
+
+	// Accesses alternate between both regions and revisit a small working set
+	auto interleaved = [&](MemoryDevice &memory_device) {
+		for (Size i = 0; i < N; i++) {
+			Size offset = sizeof(Data) * (i % 8);
+			Data data = static_cast<Data>(i);
+			memory_device.write(first_region + offset, &data, sizeof(data));
+			memory_device.read(&data, second_region + offset, sizeof(data));
+		}
+	};
+
+	auto test = [&](MemoryDevice &cache) {
+		Catch::Timer timer{};
+		timer.start();
+		interleaved(cache);
+		return timer.getElapsedMicroseconds();
+	};
+
+	SECTION("interleaved access needs fewer transactions") {
+		AccessCounter window_counter{slow_layer};
+		CacheLayer<cache_size> window{window_counter};
+		auto window_time = test(window);
+		window.flush();
+
+		AccessCounter lru_counter{slow_layer};
+		LRUCacheLayer<line_size, cache_size / line_size, 2> lru{lru_counter};
+		auto lru_time = test(lru);
+		lru.flush();
+
+		int window_transactions =
+			window_counter.reads() + window_counter.writes();
+		int lru_transactions = lru_counter.reads() + lru_counter.writes();
+		double lru_hit_rate =
+			double(lru.hits()) / double(lru.hits() + lru.misses());
+
+		std::cout << "single window: " << window_transactions
+				  << " transactions, " << window_time << "us\n"
+				  << "lru: " << lru_transactions << " transactions, "
+				  << lru_hit_rate * 100 << "% hits, " << lru_time << "us\n";
+
+		REQUIRE(lru_transactions < window_transactions);
+		REQUIRE(lru_time <= window_time);
+	}
+}
@@ -0,0 +1,52 @@
+#include "../layers/access_counter.hpp"
+#include "../layers/prefetch_layer.hpp"
+#include "../mocks/mock_memory_device.hpp"
+#include "../mocks/mock_slow_layer.hpp"
+#include <catch2/catch_all.hpp>
+#include <iostream>
+
+using namespace rambock;
+using namespace mocks;
+using namespace layers;
+
+TEST_CASE("benchmark prefetch", "[benchmarks]") {
+	using Data = int;
+	constexpr Size memory_size = 4096;
+	constexpr Size buffer_size = 128;
+	MockMemoryDevice<memory_size> memory_device{};
+	MockSlowLayer<1> slow_layer{memory_device};
+
+	auto scan = [](MemoryDevice &memory_device, Size stride) {
+		Catch::Timer timer{};
+		timer.start();
+		for (Address address = Address::null();
+			 address + sizeof(Data) <= Address{memory_size};
+			 address += stride) {
+			Data data{};
+			memory_device.read(&data, address, sizeof(data));
+		}
+		return timer.getElapsedMicroseconds();
+	};
+
+	auto compare = [&](Size stride) {
+		AccessCounter direct_counter{slow_layer};
+		auto direct_time = scan(direct_counter, stride);
+
+		AccessCounter prefetch_counter{slow_layer};
+		PrefetchLayer<buffer_size> prefetch{
+			prefetch_counter, Address{memory_size}};
+		auto prefetch_time = scan(prefetch, stride);
+
+		std::cout << "stride " << stride << ": direct "
+				  << direct_counter.reads() << " reads, " << direct_time
+				  << "us, prefetch " << prefetch_counter.reads() << " reads, "
+				  << prefetch_time << "us\n";
+
+		REQUIRE(prefetch_counter.reads() < direct_counter.reads());
+		REQUIRE(prefetch_time <= direct_time);
+	};
+
+	SECTION("linear scans need fewer reads") { compare(sizeof(Data)); }
+
+	SECTION("strided scans need fewer reads") { compare(3 * sizeof(Data)); }
+}
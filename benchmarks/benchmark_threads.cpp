@@ -0,0 +1,106 @@
+#include "../allocators/concurrent_allocator.hpp"
+#include "../allocators/segregated_allocator.hpp"
+#include "../layers/lru_cache_layer.hpp"
+#include "../layers/sharded_cache_layer.hpp"
+#include "../mocks/mock_memory_device.hpp"
+#include <catch2/catch_all.hpp>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace rambock;
+using namespace allocators;
+using namespace layers;
+using namespace mocks;
+
+TEST_CASE("benchmark threads", "[benchmarks]") {
+	constexpr Size memory_size = 256 * 1024;
+	constexpr size_t operations = 20000;
+	constexpr size_t live_blocks = 16;
+	static MockMemoryDevice<memory_size> memory_device{};
+
+	const size_t cores = std::thread::hardware_concurrency();
+	const size_t max_threads = cores > 1 ? cores : 1;
+
+	// Every thread keeps a few blocks alive, replacing one at a time
+	auto work = [&](BaseAllocator &allocator,
+					MemoryDevice &device,
+					std::mutex *global,
+					size_t thread) {
+		Address blocks[live_blocks] = {};
+		bool ok = true;
+		for (size_t i = 0; i < operations; i++) {
+			Address &block = blocks[i % live_blocks];
+			const int value = int(thread << 20 | i);
+			std::unique_lock<std::mutex> lock;
+			if (global) {
+				lock = std::unique_lock<std::mutex>{*global};
+			}
+			if (block) {
+				allocator.free(block);
+			}
+			block = allocator.allocate(Size(16 + i % 48));
+			device.write(block, &value, sizeof(value));
+			int readback = 0;
+			device.read(&readback, block, sizeof(readback));
+			ok = ok && readback == value;
+		}
+		for (Address block : blocks) {
+			std::unique_lock<std::mutex> lock;
+			if (global) {
+				lock = std::unique_lock<std::mutex>{*global};
+			}
+			allocator.free(block);
+		}
+		return ok;
+	};
+
+	// Run threads in parallel and get operations per millisecond
+	auto run = [&](size_t thread_count,
+				   BaseAllocator &allocator,
+				   MemoryDevice &device,
+				   std::mutex *global) {
+		std::vector<std::thread> threads;
+		std::vector<char> ok(thread_count, 0);
+		Catch::Timer timer{};
+		timer.start();
+		for (size_t t = 0; t < thread_count; t++) {
+			threads.emplace_back([&, t] {
+				ok[t] = work(allocator, device, global, t);
+			});
+		}
+		for (std::thread &thread : threads) {
+			thread.join();
+		}
+		const auto elapsed = timer.getElapsedMicroseconds();
+		for (char thread_ok : ok) {
+			REQUIRE(thread_ok);
+		}
+		return double(thread_count * operations) * 1000 /
+			   double(elapsed ? elapsed : 1);
+	};
+
+	for (size_t thread_count = 1; thread_count <= max_threads;
+		 thread_count *= 2) {
+		std::mutex global{};
+		LRUCacheLayer<32, 64> locked_cache{memory_device};
+		SegregatedAllocator<12> locked{locked_cache, Address(memory_size)};
+		const double locked_rate =
+			run(thread_count, locked, locked_cache, &global);
+
+		ShardedCacheLayer<32, 8> sharded_cache{memory_device};
+		SegregatedAllocator<12> backend{sharded_cache, Address(memory_size)};
+		ConcurrentAllocator<> concurrent{backend};
+		const double concurrent_rate =
+			run(thread_count, concurrent, sharded_cache, nullptr);
+
+		std::cout << thread_count << " threads: global lock " << locked_rate
+				  << " ops/ms, sharded " << concurrent_rate << " ops/ms\n";
+
+		if (thread_count < max_threads && thread_count * 2 > max_threads) {
+			// end with all cores
+			thread_count = max_threads / 2;
+		}
+	}
+}
@@ -0,0 +1,93 @@
+#include "../allocators/simple_allocator.hpp"
+#include "../drivers/mmap_memory_device.hpp"
+#include "../external_vector.hpp"
+#include "../helpers/trace_replay.hpp"
+#include "../layers/cache_layer.hpp"
+#include "../layers/lru_cache_layer.hpp"
+#include "../layers/trace_recorder.hpp"
+#include "../mocks/mock_slow_layer.hpp"
+#include <catch2/catch_all.hpp>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+using namespace rambock;
+using namespace mocks;
+using namespace layers;
+
+namespace {
+
+void collect(const uint8_t *data, size_t size, void *context) {
+	auto &trace = *static_cast<std::vector<uint8_t> *>(context);
+	trace.insert(trace.end(), data, data + size);
+}
+
+} // namespace
+
+// Set RAMBOCK_TRACE to the path of a recorded trace to replay it instead
+TEST_CASE("benchmark trace replay", "[benchmarks]") {
+	constexpr Size memory_size = 1 << 20;
+	constexpr Size cache_size = 256;
+	constexpr Size line_size = 32;
+	std::vector<uint8_t> trace{};
+
+	const char *path = std::getenv("RAMBOCK_TRACE");
+	if (path) {
+		std::ifstream file{path, std::ios::binary};
+		REQUIRE(file);
+		trace.assign(std::istreambuf_iterator<char>{file},
+					 std::istreambuf_iterator<char>{});
+	} else {
+		// Several vectors growing side by side, then read back
+		MmapMemoryDevice memory_device{memory_size};
+		TraceRecorder recorder{memory_device, &collect, &trace};
+		allocators::SimpleAllocator allocator{recorder, Address(memory_size)};
+		std::vector<external_vector<int>> vectors{};
+		for (int i = 0; i < 4; i++) {
+			vectors.emplace_back(allocator);
+		}
+		for (int i = 0; i < 256; i++) {
+			REQUIRE(vectors[i % 4].push_back(i));
+		}
+		for (const external_vector<int> &vector : vectors) {
+			int value = 0;
+			for (size_t i = 0; i < vector.size(); i++) {
+				vector.read_range(i, &value, 1);
+			}
+		}
+	}
+	REQUIRE(!trace.empty());
+
+	MmapMemoryDevice memory_device{memory_size};
+	MockSlowLayer<1> slow_layer{memory_device};
+	AccessProfiler bus{slow_layer};
+
+	auto report = [&](const char *name, MemoryDevice &stack) {
+		const helpers::ReplayResult result =
+			helpers::replay(trace.data(), trace.size(), stack, &bus);
+		REQUIRE(result.complete);
+		std::cout << name << ": " << result.records << " records, "
+				  << result.transactions << " transactions, "
+				  << result.transferred << " bytes, " << result.time / 1000
+				  << "us\n";
+		return result;
+	};
+
+	SECTION("caches reduce transactions of a recorded trace") {
+		std::cout << "trace: " << trace.size() << " bytes\n";
+		const helpers::ReplayResult uncached = report("uncached", bus);
+
+		CacheLayer<cache_size> window{bus};
+		const helpers::ReplayResult windowed = report("single window", window);
+		window.flush();
+
+		LRUCacheLayer<line_size, cache_size / line_size, 2> lru{bus};
+		const helpers::ReplayResult lined = report("lru", lru);
+		lru.flush();
+
+		REQUIRE(windowed.transactions < uncached.transactions);
+		REQUIRE(lined.transactions < uncached.transactions);
+	}
+}
@@ -9,11 +9,17 @@ namespace rambock {
  * Website: https://www.microchip.com/en-us/product/23LC1024
  * Datasheet: https://ww1.microchip.com/downloads/en/DeviceDoc/20005142C.pdf
  *
- * Only supports SPI mode
+ * Transfers data in bursts through buffered SPI transfers. In quad mode the
+ * chip is switched to SQI once set up, transfers then clock four data pins
+ * through digital IO and take a quarter of the bus cycles. Dual mode is not
+ * supported.
+ *
+ * The operating mode decides how much a single transaction may transfer:
+ * sequential transactions cover the whole array, page transactions are split
+ * at page boundaries and byte transactions transfer a single byte.
  */
 class Driver_23LC1024 : public MemoryDevice {
-	static const SPISettings SPI_SETTINGS;
-
+  public:
 	enum Mode {
 		BYTE = 0x00,
 		PAGE = 0x80,
@@ -21,6 +27,17 @@ class Driver_23LC1024 : public MemoryDevice {
 		RESEVED = 0xc0,
 	};
 
+	/** Pins used in quad mode
+	 * sio0 and sio1 are shared with MOSI and MISO of the SPI bus.
+	 */
+	struct QuadPins {
+		int sck;
+		int sio[4];
+	};
+
+  private:
+	static const SPISettings SPI_SETTINGS;
+
 	enum Command {
 		READ = 0x03,
 		WRITE = 0x02,
@@ -35,28 +52,117 @@ class Driver_23LC1024 : public MemoryDevice {
 	void setMode(Mode mode);
 	void sendAddress(Address address);
 
+	// select the chip and start a transaction at an address
+	void beginTransfer(Command command, Address address);
+	void endTransfer();
+
+	/** Continue the open transaction at an address or start a new one
+	 * @param count the number of bytes to transfer
+	 * @return the number of bytes the transaction can take, at most count
+	 */
+	Size seek(Command command, Address address, Size count);
+
+	// number of bytes a transaction starting at an address can transfer
+	Size room(Address address) const;
+
+	// transfer a range, continuing the open transaction if possible
+	void receive(uint8_t *to, Address from, Size count);
+	void send(Address to, const uint8_t *from, Size count);
+
+	// shift bytes through the open transaction
+	void sendBytes(const uint8_t *data, Size count);
+	void receiveBytes(uint8_t *data, Size count);
+
+	// clock a byte in quad mode
+	void sendQuad(uint8_t data);
+	uint8_t receiveQuad();
+	void setQuadPins(int mode);
+
+	void sendByte(uint8_t data);
+
+	static inline Address address_of(const ReadSegment &segment) {
+		return segment.from;
+	}
+	static inline Address address_of(const WriteSegment &segment) {
+		return segment.to;
+	}
+
+	/** Iterate segments in ascending address order without reordering them
+	 * @param previous the last segment returned, nullptr to start
+	 * @return the following segment or nullptr if none is left
+	 */
+	template <typename Segment>
+	static const Segment *
+	nextSegment(const Segment *segments, size_t n, const Segment *previous);
+
 	int m_cs;
+	Mode m_mode;
+	bool m_quad;
+	QuadPins m_pins;
+
+	// open transaction, continues at m_position for m_room bytes
+	bool m_open;
+	Command m_command;
+	Address m_position;
+	Size m_room;
 
   public:
-	explicit Driver_23LC1024(int cs);
+	/** Constructor for SPI transfers
+	 * @param cs the chip select pin
+	 * @param mode the operating mode
+	 */
+	explicit Driver_23LC1024(int cs, Mode mode = Mode::SEQUENTIAL);
+
+	/** Constructor for quad transfers
+	 * @param cs the chip select pin
+	 * @param pins the clock and data pins
+	 * @param mode the operating mode
+	 */
+	Driver_23LC1024(int cs, QuadPins pins, Mode mode = Mode::SEQUENTIAL);
 
 	/** Address just past last addressable byte
 	 * @return length of array in bytes
 	 */
 	static inline Size size() { return 0x20000; }
 
+	/** Number of bytes in a page
+	 */
+	static inline Size pageSize() { return 32; }
+
 	/** Sets up the device for random access
-	 * Sets the CS pin to output mode and resets the chip to SPI mode
+	 * Sets the CS pin to output mode, resets the chip to SPI mode and sets the
+	 * operating mode. In quad mode the chip is then switched to SQI and the
+	 * SPI bus is released, it cannot be shared with other devices.
 	 */
 	void begin();
 
-	virtual void *read(Address from, void *to, Size count) override;
+	virtual void *read(void *to, Address from, Size count) override;
 	virtual Address write(Address to, const void *from, Size count) override;
+
+	/** Transfers segments sorted by address
+	 * Adjacent segments share a single transaction where the mode allows.
+	 */
+	virtual void readv(const ReadSegment *segments, size_t n) override;
+	virtual void writev(const WriteSegment *segments, size_t n) override;
 };
 
 const SPISettings Driver_23LC1024::SPI_SETTINGS(F_CPU, MSBFIRST, SPI_MODE0);
 
-Driver_23LC1024::Driver_23LC1024(int cs) : m_cs(cs) {}
+Driver_23LC1024::Driver_23LC1024(int cs, Mode mode)
+	: m_cs(cs)
+	, m_mode(mode)
+	, m_quad(false)
+	, m_pins{-1, {-1, -1, -1, -1}}
+	, m_open(false)
+	, m_command(Command::READ)
+	, m_position(Address::null())
+	, m_room(0) {}
+
+Driver_23LC1024::Driver_23LC1024(int cs, QuadPins pins, Mode mode)
+	: Driver_23LC1024(cs, mode) {
+	m_quad = true;
+	m_pins = pins;
+}
 
 void Driver_23LC1024::reset() {
 	SPI.beginTransaction(SPI_SETTINGS);
@@ -74,7 +180,21 @@ void Driver_23LC1024::begin() {
 	digitalWrite(m_cs, HIGH);
 
 	reset();
-	setMode(Mode::SEQUENTIAL);
+	setMode(m_mode);
+
+	if (m_quad) {
+		SPI.beginTransaction(SPI_SETTINGS);
+		digitalWrite(m_cs, LOW);
+		SPI.transfer(Command::EQIO);
+		digitalWrite(m_cs, HIGH);
+		SPI.endTransaction();
+
+		// take over the data pins
+		SPI.end();
+		pinMode(m_pins.sck, OUTPUT);
+		digitalWrite(m_pins.sck, LOW);
+		setQuadPins(OUTPUT);
+	}
 }
 
 void Driver_23LC1024::setMode(Mode mode) {
@@ -90,45 +210,215 @@ void Driver_23LC1024::setMode(Mode mode) {
 
 void Driver_23LC1024::sendAddress(Address address) {
 	// only 24 bit address, next 7 bits also ignored
-	SPI.transfer((uint8_t)(address >> 16));
-	SPI.transfer((uint8_t)(address >> 8));
-	SPI.transfer((uint8_t)(address >> 0));
+	sendByte((uint8_t)(address.value >> 16));
+	sendByte((uint8_t)(address.value >> 8));
+	sendByte((uint8_t)(address.value >> 0));
 }
 
-void *Driver_23LC1024::read(Address from, void *to, Size count) {
-	SPI.beginTransaction(SPI_SETTINGS);
+void Driver_23LC1024::beginTransfer(Command command, Address address) {
+	if (!m_quad) {
+		SPI.beginTransaction(SPI_SETTINGS);
+	}
 	digitalWrite(m_cs, LOW);
 
-	SPI.transfer(Command::READ);
-	sendAddress(from);
-
-	uint8_t *data = static_cast<uint8_t *>(to);
-	for (Size i = 0; i < count; i++) {
-		data[i] = SPI.transfer(0);
+	sendByte(command);
+	sendAddress(address);
+	if (m_quad && command == Command::READ) {
+		// SQI reads wait for a dummy byte before the chip drives the pins
+		sendQuad(0);
+		setQuadPins(INPUT);
 	}
 
+	m_open = true;
+	m_command = command;
+	m_position = address;
+	m_room = room(address);
+}
+
+void Driver_23LC1024::endTransfer() {
 	digitalWrite(m_cs, HIGH);
-	SPI.endTransaction();
+	if (m_quad) {
+		setQuadPins(OUTPUT);
+	} else {
+		SPI.endTransaction();
+	}
+	m_open = false;
+}
+
+Size Driver_23LC1024::seek(Command command, Address address, Size count) {
+	if (!m_open || m_command != command || m_position != address ||
+		m_room == 0) {
+		if (m_open) {
+			endTransfer();
+		}
+		beginTransfer(command, address);
+	}
+	if (count > m_room) {
+		count = m_room;
+	}
+	m_position += count;
+	m_room -= count;
+	return count;
+}
+
+Size Driver_23LC1024::room(Address address) const {
+	switch (m_mode) {
+	case Mode::BYTE:
+		return 1;
+	case Mode::PAGE:
+		// the address wraps around within a page
+		return pageSize() - address.value % pageSize();
+	default:
+		// the address wraps around at the end of the array
+		return size() - address.value % size();
+	}
+}
+
+void Driver_23LC1024::sendBytes(const uint8_t *data, Size count) {
+	if (m_quad) {
+		for (Size i = 0; i < count; i++) {
+			sendQuad(data[i]);
+		}
+		return;
+	}
+	// buffer transfers overwrite their data, so send a copy
+	uint8_t buffer[DEVICE_BUFFER_SIZE];
+	for (Size done = 0; done < count;) {
+		Size n = count - done < sizeof(buffer) ? count - done : sizeof(buffer);
+		memcpy(buffer, data + done, n);
+		SPI.transfer(buffer, n);
+		done += n;
+	}
+}
+
+void Driver_23LC1024::receiveBytes(uint8_t *data, Size count) {
+	if (m_quad) {
+		for (Size i = 0; i < count; i++) {
+			data[i] = receiveQuad();
+		}
+		return;
+	}
+	// the chip ignores its input while reading
+	SPI.transfer(data, count);
+}
+
+void Driver_23LC1024::sendQuad(uint8_t data) {
+	for (int shift = 4; shift >= 0; shift -= 4) {
+		for (int i = 0; i < 4; i++) {
+			digitalWrite(m_pins.sio[i], (data >> (shift + i)) & 1 ? HIGH : LOW);
+		}
+		digitalWrite(m_pins.sck, HIGH);
+		digitalWrite(m_pins.sck, LOW);
+	}
+}
+
+uint8_t Driver_23LC1024::receiveQuad() {
+	uint8_t data = 0;
+	for (int shift = 4; shift >= 0; shift -= 4) {
+		digitalWrite(m_pins.sck, HIGH);
+		for (int i = 0; i < 4; i++) {
+			data |= uint8_t(digitalRead(m_pins.sio[i]) == HIGH) << (shift + i);
+		}
+		digitalWrite(m_pins.sck, LOW);
+	}
+	return data;
+}
+
+void Driver_23LC1024::setQuadPins(int mode) {
+	for (int pin : m_pins.sio) {
+		pinMode(pin, mode);
+	}
+}
+
+void Driver_23LC1024::sendByte(uint8_t data) {
+	if (m_quad) {
+		sendQuad(data);
+	} else {
+		SPI.transfer(data);
+	}
+}
+
+void Driver_23LC1024::receive(uint8_t *to, Address from, Size count) {
+	for (Size done = 0; done < count;) {
+		const Size n = seek(Command::READ, from + done, count - done);
+		receiveBytes(to + done, n);
+		done += n;
+	}
+}
+
+void Driver_23LC1024::send(Address to, const uint8_t *from, Size count) {
+	for (Size done = 0; done < count;) {
+		const Size n = seek(Command::WRITE, to + done, count - done);
+		sendBytes(from + done, n);
+		done += n;
+	}
+}
+
+void *Driver_23LC1024::read(void *to, Address from, Size count) {
+	receive(static_cast<uint8_t *>(to), from, count);
+	if (m_open) {
+		endTransfer();
+	}
 
 	return to;
 }
 
 Address Driver_23LC1024::write(Address to, const void *from, Size count) {
-	SPI.beginTransaction(SPI_SETTINGS);
-	digitalWrite(m_cs, LOW);
+	send(to, static_cast<const uint8_t *>(from), count);
+	if (m_open) {
+		endTransfer();
+	}
 
-	SPI.transfer(Command::WRITE);
-	sendAddress(to);
+	return to;
+}
+template <typename Segment>
+const Segment *Driver_23LC1024::nextSegment(const Segment *segments,
+											size_t n,
+											const Segment *previous) {
+	// order by address, ties by position to visit every segment once
+	auto before = [](const Segment *a, const Segment *b) {
+		return address_of(*a) < address_of(*b) ||
+			   (address_of(*a) == address_of(*b) && a < b);
+	};
 
-	const uint8_t *data = static_cast<const uint8_t *>(from);
-	for (Size i = 0; i < count; i++) {
-		SPI.transfer(data[i]);
+	const Segment *next = nullptr;
+	for (size_t i = 0; i < n; i++) {
+		const Segment *candidate = &segments[i];
+		if (previous && !before(previous, candidate)) {
+			continue;
+		}
+		if (!next || before(candidate, next)) {
+			next = candidate;
+		}
 	}
+	return next;
+}
 
-	digitalWrite(m_cs, HIGH);
-	SPI.endTransaction();
+void Driver_23LC1024::readv(const ReadSegment *segments, size_t n) {
+	// adjacent segments continue the open transaction
+	const ReadSegment *segment = nextSegment<ReadSegment>(segments, n, nullptr);
+	for (; segment; segment = nextSegment(segments, n, segment)) {
+		receive(static_cast<uint8_t *>(segment->to),
+				segment->from,
+				segment->count);
+	}
+	if (m_open) {
+		endTransfer();
+	}
+}
 
-	return to;
+void Driver_23LC1024::writev(const WriteSegment *segments, size_t n) {
+	// adjacent segments continue the open transaction
+	const WriteSegment *segment =
+		nextSegment<WriteSegment>(segments, n, nullptr);
+	for (; segment; segment = nextSegment(segments, n, segment)) {
+		send(segment->to,
+			 static_cast<const uint8_t *>(segment->from),
+			 segment->count);
+	}
+	if (m_open) {
+		endTransfer();
+	}
 }
 
 } // namespace rambock
@@ -0,0 +1,78 @@
+#include "file_memory_device.hpp"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+rambock::FileMemoryDevice::FileMemoryDevice(const char *path, Size size)
+	: _fd{open(path, O_RDWR | O_CREAT, 0644)}
+	, _size{size} {
+	struct stat status {};
+	if (_fd < 0 || fstat(_fd, &status) != 0) {
+		return;
+	}
+	// never truncate existing contents
+	if (status.st_size < off_t(size) && ftruncate(_fd, off_t(size)) != 0) {
+		close(_fd);
+		_fd = -1;
+	}
+}
+
+rambock::FileMemoryDevice::~FileMemoryDevice() {
+	if (is_open()) {
+		close(_fd);
+	}
+}
+
+void *rambock::FileMemoryDevice::read(void *to, Address from, Size n) {
+	if (!contains(from, n)) {
+		return nullptr;
+	}
+	uint8_t *bytes = static_cast<uint8_t *>(to);
+	for (Size done = 0; done < n;) {
+		const ssize_t count =
+			pread(_fd, bytes + done, n - done, off_t(from.value) + done);
+		if (count < 0 && errno == EINTR) {
+			continue;
+		}
+		if (count <= 0) {
+			return nullptr;
+		}
+		done += Size(count);
+	}
+	return to;
+}
+
+rambock::Address
+rambock::FileMemoryDevice::write(Address to, const void *from, Size n) {
+	if (!contains(to, n)) {
+		return Address::null();
+	}
+	const uint8_t *bytes = static_cast<const uint8_t *>(from);
+	for (Size done = 0; done < n;) {
+		const ssize_t count =
+			pwrite(_fd, bytes + done, n - done, off_t(to.value) + done);
+		if (count < 0 && errno == EINTR) {
+			continue;
+		}
+		if (count <= 0) {
+			return Address::null();
+		}
+		done += Size(count);
+	}
+	return to;
+}
+
+void rambock::FileMemoryDevice::fill(Address to, uint8_t value, Size n) {
+	uint8_t buffer[FILE_BUFFER_SIZE];
+	fill_through(to, value, n, buffer, sizeof(buffer));
+}
+
+void rambock::FileMemoryDevice::move(Address to, Address from, Size n) {
+	uint8_t buffer[FILE_BUFFER_SIZE];
+	move_through(to, from, n, buffer, sizeof(buffer));
+}
+
+bool rambock::FileMemoryDevice::sync() {
+	return is_open() && fsync(_fd) == 0;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "../memory_device.hpp"
+
+// Local buffer used to fill and move ranges of a file, in bytes
+#ifndef FILE_BUFFER_SIZE
+#define FILE_BUFFER_SIZE 4096
+#endif
+
+namespace rambock {
+
+/** Device storing its contents in a file
+ * For hosted builds only. Every access is a single pread or pwrite at the
+ * offset of its address, so the file can be much larger than local memory.
+ * Accesses past the end of the device fail without touching the file.
+ */
+struct FileMemoryDevice : public MemoryDevice {
+	/** Opens a file, creating it if needed
+	 * @param path the file to store contents in
+	 * @param size the number of bytes, the file is extended if shorter
+	 */
+	FileMemoryDevice(const char *path, Size size);
+	FileMemoryDevice(const FileMemoryDevice &) = delete;
+	FileMemoryDevice &operator=(const FileMemoryDevice &) = delete;
+
+	/** Closes the file
+	 */
+	~FileMemoryDevice() override;
+
+	/** Check whether the file could be opened and sized
+	 */
+	inline bool is_open() const { return _fd >= 0; }
+
+	/** Address just past last addressable byte
+	 */
+	inline Size size() const { return _size; }
+
+	/** Reads from the file
+	 * @return null if the range is out of bounds or the file cannot be read
+	 */
+	void *read(void *to, Address from, Size n) override;
+
+	/** Writes to the file
+	 * @return null if the range is out of bounds or the file cannot be written
+	 */
+	Address write(Address to, const void *from, Size n) override;
+
+	void fill(Address to, uint8_t value, Size n) override;
+	void move(Address to, Address from, Size n) override;
+
+	/** Flushes written data to the storage device
+	 * @return false if the file could not be synchronized
+	 */
+	bool sync();
+
+  private:
+	// check whether a range lies within the device
+	inline bool contains(Address address, Size n) const {
+		return is_open() && address.value <= _size &&
+			   n <= _size - address.value;
+	}
+
+	int _fd;
+	Size _size;
+};
+
+} // namespace rambock
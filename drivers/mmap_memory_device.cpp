@@ -0,0 +1,83 @@
+#include "mmap_memory_device.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+rambock::MmapMemoryDevice::MmapMemoryDevice(const char *path, Size size)
+	: _fd{open(path, O_RDWR | O_CREAT, 0644)}
+	, _size{size}
+	, _memory{nullptr} {
+	struct stat status {};
+	if (_fd < 0 || fstat(_fd, &status) != 0) {
+		return;
+	}
+	// never truncate existing contents
+	if (status.st_size < off_t(size) && ftruncate(_fd, off_t(size)) != 0) {
+		return;
+	}
+	map(_fd);
+}
+
+rambock::MmapMemoryDevice::MmapMemoryDevice(Size size)
+	: _fd{-1}
+	, _size{size}
+	, _memory{nullptr} {
+	map(-1);
+}
+
+rambock::MmapMemoryDevice::~MmapMemoryDevice() {
+	if (_memory) {
+		munmap(_memory, _size);
+	}
+	if (_fd >= 0) {
+		close(_fd);
+	}
+}
+
+void *rambock::MmapMemoryDevice::read(void *to, Address from, Size n) {
+	if (!contains(from, n)) {
+		return nullptr;
+	}
+	return memcpy(to, _memory + from.value, n);
+}
+
+rambock::Address
+rambock::MmapMemoryDevice::write(Address to, const void *from, Size n) {
+	if (!contains(to, n)) {
+		return Address::null();
+	}
+	memcpy(_memory + to.value, from, n);
+	return to;
+}
+
+void rambock::MmapMemoryDevice::fill(Address to, uint8_t value, Size n) {
+	if (contains(to, n)) {
+		memset(_memory + to.value, value, n);
+	}
+}
+
+void rambock::MmapMemoryDevice::copy(Address to, Address from, Size n) {
+	if (contains(to, n) && contains(from, n)) {
+		memcpy(_memory + to.value, _memory + from.value, n);
+	}
+}
+
+void rambock::MmapMemoryDevice::move(Address to, Address from, Size n) {
+	if (contains(to, n) && contains(from, n)) {
+		memmove(_memory + to.value, _memory + from.value, n);
+	}
+}
+
+bool rambock::MmapMemoryDevice::sync() {
+	return is_open() && (_fd < 0 || msync(_memory, _size, MS_SYNC) == 0);
+}
+
+void rambock::MmapMemoryDevice::map(int fd) {
+	const int flags = fd < 0 ? MAP_PRIVATE | MAP_ANONYMOUS : MAP_SHARED;
+	void *memory =
+		mmap(nullptr, _size, PROT_READ | PROT_WRITE, flags, fd, 0);
+	if (memory != MAP_FAILED) {
+		_memory = static_cast<uint8_t *>(memory);
+	}
+}
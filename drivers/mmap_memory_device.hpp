@@ -0,0 +1,80 @@
+#pragma once
+
+#include "../memory_device.hpp"
+
+namespace rambock {
+
+/** Device backed by a memory mapping
+ * For hosted builds only. Maps a file, or anonymous memory, and serves all
+ * accesses with memcpy. Code that can work on the mapping directly may use
+ * data() instead of copying. Accesses past the end of the device fail.
+ */
+struct MmapMemoryDevice : public MemoryDevice {
+	/** Maps a file, creating it if needed
+	 * @param path the file to map, changes are written back to it
+	 * @param size the number of bytes, the file is extended if shorter
+	 */
+	MmapMemoryDevice(const char *path, Size size);
+
+	/** Maps anonymous memory, initialized to zero
+	 * @param size the number of bytes
+	 */
+	explicit MmapMemoryDevice(Size size);
+
+	MmapMemoryDevice(const MmapMemoryDevice &) = delete;
+	MmapMemoryDevice &operator=(const MmapMemoryDevice &) = delete;
+
+	/** Unmaps the memory, closing the file if any
+	 */
+	~MmapMemoryDevice() override;
+
+	/** Check whether the memory could be mapped
+	 */
+	inline bool is_open() const { return _memory != nullptr; }
+
+	/** Address just past last addressable byte
+	 */
+	inline Size size() const { return _size; }
+
+	/** Get the mapped bytes at an address without copying
+	 * @return pointer into the mapping or nullptr if out of bounds
+	 */
+	inline uint8_t *data(Address address) const {
+		return contains(address, 0) ? _memory + address.value : nullptr;
+	}
+
+	/** Reads from the mapping
+	 * @return null if the range is out of bounds
+	 */
+	void *read(void *to, Address from, Size n) override;
+
+	/** Writes to the mapping
+	 * @return null if the range is out of bounds
+	 */
+	Address write(Address to, const void *from, Size n) override;
+
+	void fill(Address to, uint8_t value, Size n) override;
+	void copy(Address to, Address from, Size n) override;
+	void move(Address to, Address from, Size n) override;
+
+	/** Writes changes back to the mapped file
+	 * @return false if the mapping could not be synchronized
+	 */
+	bool sync();
+
+  private:
+	// check whether a range lies within the device
+	inline bool contains(Address address, Size n) const {
+		return is_open() && address.value <= _size &&
+			   n <= _size - address.value;
+	}
+
+	// map the file or anonymous memory if fd is negative
+	void map(int fd);
+
+	int _fd;
+	Size _size;
+	uint8_t *_memory;
+};
+
+} // namespace rambock
@@ -8,8 +8,8 @@ namespace rambock {
 
 template <typename T> struct external_ptr {
 	using Allocator = rambock::allocators::BaseAllocator;
-	static constexpr Size allocation_size =
-		sizeof(typename LocalCopy<T>::ExternalFrame);
+	// objects are stored as they are, without any bookkeeping
+	static constexpr Size allocation_size = sizeof(T);
 
 	constexpr external_ptr() = default;
 	constexpr explicit external_ptr(Allocator &allocator);
@@ -34,6 +34,21 @@ template <typename T> struct external_ptr {
 	inline external_ptr operator+(size_t i) const;
 	inline external_ptr operator-(size_t i) const;
 	inline LocalCopy<T> operator[](size_t i) const { return *(*this + i); }
+	/** Reads a copy of the object, never writing it back
+	 */
+	T load() const;
+	/** Overwrites the object without reading it first
+	 * A live copy of the object takes the value and writes it back instead.
+	 */
+	void store(const T &value) const;
+	/** Starts reading the object without waiting for it
+	 * Layers between the device and the allocator may hold newer data, so
+	 * unless the device is the allocator's own the object is read through the
+	 * allocator's device right away.
+	 * @param device asynchronous device the allocator's device is built on
+	 * @return local copy that blocks on first access until data arrived
+	 */
+	LocalCopy<T> prefetch(AsyncMemoryDevice &device) const;
 	inline void free() const { allocator().free(address()); }
 
   private:
@@ -53,6 +68,39 @@ external_ptr<T> external_ptr<T>::operator-(size_t i) const {
 	return external_ptr{allocator(), address() - i * allocation_size};
 }
 
+template <typename T> constexpr Size external_ptr<T>::allocation_size;
+
+template <typename T> T external_ptr<T>::load() const {
+	// a live copy may hold changes not written back yet
+	const T *local = static_cast<const T *>(helpers::PinTable::instance().find(
+		allocator().memory_device(), address()));
+	if (local) {
+		return *local;
+	}
+	T value;
+	allocator().memory_device().read(&value, address(), sizeof(value));
+	return value;
+}
+
+template <typename T> void external_ptr<T>::store(const T &value) const {
+	T *local = static_cast<T *>(helpers::PinTable::instance().find(
+		allocator().memory_device(), address()));
+	if (local) {
+		// the live copy writes the value back once it is destroyed
+		*local = value;
+		return;
+	}
+	allocator().memory_device().write(address(), &value, sizeof(value));
+}
+
+template <typename T>
+LocalCopy<T> external_ptr<T>::prefetch(AsyncMemoryDevice &device) const {
+	if (&device != &allocator().memory_device()) {
+		return **this;
+	}
+	return LocalCopy<T>{device, address()};
+}
+
 template <typename T>
 constexpr external_ptr<T>::external_ptr(external_ptr::Allocator &allocator)
 	: _allocator{&allocator}
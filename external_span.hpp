@@ -0,0 +1,223 @@
+#pragma once
+
+#include "external_ptr.hpp"
+#include "local_copy.hpp"
+#include "memory_device.hpp"
+#include <cstddef>
+#include <iterator>
+
+namespace rambock {
+
+/** View of a range of external objects, buffered in local chunks
+ * Elements are accessed through a local buffer holding the chunk of ChunkSize
+ * bytes they lie in. A chunk is read in a single transfer on first access and
+ * only written back if one of its elements was assigned to, once another chunk
+ * is accessed or the span is flushed or destroyed.
+ *
+ * Iterators are random access and dereference to proxies that convert to T
+ * and can be assigned from T, so algorithms like std::accumulate or
+ * std::transform run over external data with one transfer per chunk.
+ * @note The range must not be accessed otherwise while the span exists
+ */
+template <typename T, Size ChunkSize = 64> struct external_span {
+	struct reference;
+	struct iterator;
+
+	/** Constructor
+	 * @param address the address of the first element
+	 * @param count the number of elements
+	 */
+	external_span(MemoryDevice &memory_device, Address address, size_t count);
+	external_span(const external_ptr<T> &first, size_t count);
+	external_span(const external_span &) = delete;
+	external_span &operator=(const external_span &) = delete;
+	~external_span();
+
+	inline MemoryDevice &memory_device() const { return *_memory_device; }
+	inline Address address() const { return _address; }
+	inline size_t size() const { return _size; }
+	inline bool empty() const { return _size == 0; }
+
+	inline iterator begin() { return iterator{this, 0}; }
+	inline iterator end() { return iterator{this, _size}; }
+	inline reference operator[](size_t i) { return reference{this, i}; }
+
+	/** Copies an element, loading its chunk if needed
+	 */
+	T load(size_t i);
+
+	/** Assigns an element, marking its chunk as modified
+	 */
+	void store(size_t i, const T &value);
+
+	/** Writes the buffered chunk back if it was modified
+	 */
+	void flush();
+
+	/** Proxy for an element
+	 */
+	struct reference {
+		inline operator T() const { return _span->load(_index); }
+		inline reference &operator=(const T &value) {
+			_span->store(_index, value);
+			return *this;
+		}
+		inline reference &operator=(const reference &other) {
+			return *this = T(other);
+		}
+
+		external_span *_span;
+		size_t _index;
+	};
+
+	struct iterator {
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = T;
+		using difference_type = ptrdiff_t;
+		using pointer = void;
+		using reference = typename external_span::reference;
+
+		inline reference operator*() const { return reference{_span, _index}; }
+		inline reference operator[](difference_type n) const {
+			return *(*this + n);
+		}
+
+		inline iterator &operator++() {
+			++_index;
+			return *this;
+		}
+		inline iterator &operator--() {
+			--_index;
+			return *this;
+		}
+		inline iterator operator++(int) {
+			iterator copy = *this;
+			++_index;
+			return copy;
+		}
+		inline iterator operator--(int) {
+			iterator copy = *this;
+			--_index;
+			return copy;
+		}
+		inline iterator &operator+=(difference_type n) {
+			_index += n;
+			return *this;
+		}
+		inline iterator &operator-=(difference_type n) {
+			_index -= n;
+			return *this;
+		}
+		inline iterator operator+(difference_type n) const {
+			return iterator{_span, size_t(_index + n)};
+		}
+		inline iterator operator-(difference_type n) const {
+			return iterator{_span, size_t(_index - n)};
+		}
+		inline friend iterator operator+(difference_type n, const iterator &i) {
+			return i + n;
+		}
+		inline difference_type operator-(const iterator &other) const {
+			return difference_type(_index) - difference_type(other._index);
+		}
+
+		inline bool operator==(const iterator &rhs) const {
+			return _index == rhs._index;
+		}
+		inline bool operator!=(const iterator &rhs) const {
+			return _index != rhs._index;
+		}
+		inline bool operator<(const iterator &rhs) const {
+			return _index < rhs._index;
+		}
+		inline bool operator>(const iterator &rhs) const {
+			return _index > rhs._index;
+		}
+		inline bool operator<=(const iterator &rhs) const {
+			return _index <= rhs._index;
+		}
+		inline bool operator>=(const iterator &rhs) const {
+			return _index >= rhs._index;
+		}
+
+		external_span *_span;
+		size_t _index;
+	};
+
+  private:
+	static constexpr size_t ELEMENTS_PER_CHUNK =
+		ChunkSize / sizeof(T) > 0 ? ChunkSize / sizeof(T) : 1;
+
+	// make sure the chunk holding an element is buffered
+	T &buffered(size_t i);
+
+	MemoryDevice *_memory_device;
+	Address _address;
+	size_t _size;
+
+	T _chunk[ELEMENTS_PER_CHUNK];
+	// buffered elements, none if _loaded is 0
+	size_t _first, _loaded;
+	bool _dirty;
+};
+
+template <typename T, Size C>
+constexpr size_t external_span<T, C>::ELEMENTS_PER_CHUNK;
+
+template <typename T, Size C>
+external_span<T, C>::external_span(MemoryDevice &memory_device,
+								   Address address,
+								   size_t count)
+	: _memory_device{&memory_device}
+	, _address{address}
+	, _size{count}
+	, _chunk{}
+	, _first{0}
+	, _loaded{0}
+	, _dirty{false} {}
+
+template <typename T, Size C>
+external_span<T, C>::external_span(const external_ptr<T> &first,
+								   size_t count)
+	: external_span(
+		  first.allocator().memory_device(), first.address(), count) {}
+
+template <typename T, Size C> external_span<T, C>::~external_span() {
+	flush();
+}
+
+template <typename T, Size C> T external_span<T, C>::load(size_t i) {
+	return buffered(i);
+}
+
+template <typename T, Size C>
+void external_span<T, C>::store(size_t i, const T &value) {
+	buffered(i) = value;
+	_dirty = true;
+}
+
+template <typename T, Size C> void external_span<T, C>::flush() {
+	if (!_dirty) {
+		return;
+	}
+	memory_device().write(_address + Size(_first * sizeof(T)),
+						  _chunk,
+						  Size(_loaded * sizeof(T)));
+	_dirty = false;
+}
+
+template <typename T, Size C>
+T &external_span<T, C>::buffered(size_t i) {
+	if (_loaded == 0 || i < _first || i >= _first + _loaded) {
+		flush();
+		_first = i - i % ELEMENTS_PER_CHUNK;
+		_loaded = _size - _first < ELEMENTS_PER_CHUNK ? _size - _first
+													: ELEMENTS_PER_CHUNK;
+		memory_device().read(_chunk,
+							 _address + Size(_first * sizeof(T)),
+							 Size(_loaded * sizeof(T)));
+	}
+	return _chunk[i - _first];
+}
+
+} // namespace rambock
@@ -0,0 +1,296 @@
+#pragma once
+
+#include "allocators/base_allocator.hpp"
+#include "external_ptr.hpp"
+#include "local_copy.hpp"
+#include "memory_device.hpp"
+
+namespace rambock {
+
+/** Growable array of objects in external memory
+ * Elements are stored back to back like external_ptr<T> arrays, so data() and
+ * operator[] work with pointer based code. Range operations transfer all
+ * elements at once instead of going through one LocalCopy per element.
+ * Growing doubles the capacity and copies the elements on the device, as do
+ * insert and erase. ChunkSize bounds the local buffer used for fills.
+ *
+ * The vector owns its storage and frees it once destroyed. Operations that
+ * allocate return false if the allocator ran out of memory, leaving the vector
+ * unchanged.
+ */
+template <typename T, Size ChunkSize = 64> struct external_vector {
+	using Allocator = rambock::allocators::BaseAllocator;
+
+	explicit external_vector(Allocator &allocator);
+	external_vector(const external_vector &) = delete;
+	external_vector(external_vector &&other) noexcept;
+	external_vector &operator=(const external_vector &) = delete;
+	external_vector &operator=(external_vector &&other) noexcept;
+	~external_vector();
+
+	inline Allocator &allocator() const { return *_allocator; }
+	inline size_t size() const { return _size; }
+	inline size_t capacity() const { return _capacity; }
+	inline bool empty() const { return _size == 0; }
+
+	/** Get a pointer to the first element
+	 * @note Invalidated once the vector reallocates
+	 */
+	inline external_ptr<T> data() const {
+		return external_ptr<T>{allocator(), _data};
+	}
+	inline LocalCopy<T> operator[](size_t i) const { return data()[i]; }
+
+	/** Makes room for at least n elements
+	 * @return false if no memory was left
+	 */
+	bool reserve(size_t n);
+
+	/** Changes the number of elements
+	 * @param value copied to all new elements
+	 * @return false if no memory was left
+	 */
+	bool resize(size_t n, const T &value = T{});
+
+	bool push_back(const T &value);
+	void pop_back();
+	inline void clear() { _size = 0; }
+
+	/** Inserts elements before an index
+	 * @return false if index is out of range or no memory was left
+	 */
+	bool insert(size_t index, const T &value);
+	bool insert(size_t index, const T *from, size_t count);
+
+	/** Removes elements starting at an index
+	 * @return number of elements removed
+	 */
+	size_t erase(size_t index, size_t count = 1);
+
+	/** Copies elements to local memory
+	 * @return number of elements read, less than count at the end
+	 */
+	size_t read_range(size_t index, T *to, size_t count) const;
+
+	/** Overwrites existing elements
+	 * @return number of elements written, less than count at the end
+	 */
+	size_t write_range(size_t index, const T *from, size_t count);
+
+	/** Replaces all elements
+	 * @return false if no memory was left
+	 */
+	bool assign(const T *from, size_t count);
+
+  private:
+	static constexpr size_t ELEMENTS_PER_CHUNK =
+		ChunkSize / sizeof(T) > 0 ? ChunkSize / sizeof(T) : 1;
+
+	inline MemoryDevice &memory_device() const {
+		return allocator().memory_device();
+	}
+	inline Address element(size_t index) const {
+		return _data + Size(index * sizeof(T));
+	}
+
+	// grow the capacity geometrically to fit n elements
+	bool grow(size_t n);
+	// write elements without checking the size, *from is repeated if !step
+	void store(size_t index, const T *from, size_t count, bool step = true);
+
+	Allocator *_allocator;
+	Address _data;
+	size_t _size, _capacity;
+};
+
+template <typename T, Size C>
+constexpr size_t external_vector<T, C>::ELEMENTS_PER_CHUNK;
+
+template <typename T, Size C>
+external_vector<T, C>::external_vector(Allocator &allocator)
+	: _allocator{&allocator}
+	, _data{Address::null()}
+	, _size{0}
+	, _capacity{0} {}
+
+template <typename T, Size C>
+external_vector<T, C>::external_vector(external_vector &&other) noexcept
+	: _allocator{other._allocator}
+	, _data{other._data}
+	, _size{other._size}
+	, _capacity{other._capacity} {
+	other._data = Address::null();
+	other._size = other._capacity = 0;
+}
+
+template <typename T, Size C>
+external_vector<T, C> &
+external_vector<T, C>::operator=(external_vector &&other) noexcept {
+	if (this != &other) {
+		if (_data) {
+			allocator().free(_data);
+		}
+		_allocator = other._allocator;
+		_data = other._data;
+		_size = other._size;
+		_capacity = other._capacity;
+		other._data = Address::null();
+		other._size = other._capacity = 0;
+	}
+	return *this;
+}
+
+template <typename T, Size C> external_vector<T, C>::~external_vector() {
+	if (_data) {
+		allocator().free(_data);
+	}
+}
+
+template <typename T, Size C> bool external_vector<T, C>::reserve(size_t n) {
+	if (n <= _capacity) {
+		return true;
+	}
+	Address data = allocator().allocate(Size(n * sizeof(T)));
+	if (!data) {
+		return false;
+	}
+	if (_data) {
+		memory_device().copy(data, _data, Size(_size * sizeof(T)));
+		allocator().free(_data);
+	}
+	_data = data;
+	_capacity = n;
+	return true;
+}
+
+template <typename T, Size C>
+bool external_vector<T, C>::resize(size_t n, const T &value) {
+	if (n > _size) {
+		if (!grow(n)) {
+			return false;
+		}
+		store(_size, &value, n - _size, false);
+	}
+	_size = n;
+	return true;
+}
+
+template <typename T, Size C>
+bool external_vector<T, C>::push_back(const T &value) {
+	return insert(_size, &value, 1);
+}
+
+template <typename T, Size C> void external_vector<T, C>::pop_back() {
+	if (_size) {
+		_size--;
+	}
+}
+
+template <typename T, Size C>
+bool external_vector<T, C>::insert(size_t index, const T &value) {
+	return insert(index, &value, 1);
+}
+
+template <typename T, Size C>
+bool external_vector<T, C>::insert(size_t index,
+								   const T *from,
+								   size_t count) {
+	if (index > _size || !grow(_size + count)) {
+		return false;
+	}
+	memory_device().move(element(index + count),
+						 element(index),
+						 Size((_size - index) * sizeof(T)));
+	store(index, from, count);
+	_size += count;
+	return true;
+}
+
+template <typename T, Size C>
+size_t external_vector<T, C>::erase(size_t index, size_t count) {
+	if (index >= _size) {
+		return 0;
+	}
+	if (count > _size - index) {
+		count = _size - index;
+	}
+	memory_device().move(element(index),
+						 element(index + count),
+						 Size((_size - index - count) * sizeof(T)));
+	_size -= count;
+	return count;
+}
+
+template <typename T, Size C>
+size_t
+external_vector<T, C>::read_range(size_t index, T *to, size_t count) const {
+	if (index >= _size) {
+		return 0;
+	}
+	if (count > _size - index) {
+		count = _size - index;
+	}
+	memory_device().read(to, element(index), Size(count * sizeof(T)));
+	return count;
+}
+
+template <typename T, Size C>
+size_t
+external_vector<T, C>::write_range(size_t index, const T *from, size_t count) {
+	if (index >= _size) {
+		return 0;
+	}
+	if (count > _size - index) {
+		count = _size - index;
+	}
+	store(index, from, count);
+	return count;
+}
+
+template <typename T, Size C>
+bool external_vector<T, C>::assign(const T *from, size_t count) {
+	if (!reserve(count)) {
+		return false;
+	}
+	store(0, from, count);
+	_size = count;
+	return true;
+}
+
+template <typename T, Size C> bool external_vector<T, C>::grow(size_t n) {
+	if (n <= _capacity) {
+		return true;
+	}
+	size_t capacity = _capacity ? 2 * _capacity : ELEMENTS_PER_CHUNK;
+	if (capacity < n) {
+		capacity = n;
+	}
+	// fall back to an exact fit if doubling does not fit into memory
+	return reserve(capacity) || reserve(n);
+}
+
+template <typename T, Size C>
+void external_vector<T, C>::store(size_t index,
+								  const T *from,
+								  size_t count,
+								  bool step) {
+	if (step) {
+		memory_device().write(element(index), from, Size(count * sizeof(T)));
+		return;
+	}
+
+	// repeat the value in a chunk to write many elements at once
+	T chunk[ELEMENTS_PER_CHUNK];
+	for (T &value : chunk) {
+		value = *from;
+	}
+	for (size_t done = 0; done < count;) {
+		size_t n = count - done;
+		n = n < ELEMENTS_PER_CHUNK ? n : ELEMENTS_PER_CHUNK;
+		memory_device().write(
+			element(index + done), chunk, Size(n * sizeof(T)));
+		done += n;
+	}
+}
+
+} // namespace rambock
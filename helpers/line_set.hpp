@@ -0,0 +1,121 @@
+#pragma once
+
+#include "../memory_device.hpp"
+
+namespace rambock {
+namespace helpers {
+
+/** Local lines of a cache with LRU replacement
+ * Holds LineCount lines of LineSize bytes each, grouped into sets of
+ * Associativity lines. Lines are identified by a tag, mapping tags to sets and
+ * fetching or writing back line contents is left to the cache using them.
+ * @note Not thread-safe
+ */
+template <typename Tag,
+		  size_t LineSize,
+		  size_t LineCount,
+		  size_t Associativity = LineCount>
+struct LineSet {
+	static_assert(LineSize > 0 && LineCount > 0 && Associativity > 0,
+				  "cache geometry must not be empty");
+	static_assert(LineCount % Associativity == 0,
+				  "LineCount must be a multiple of Associativity");
+
+	static constexpr size_t SetCount = LineCount / Associativity;
+
+	struct Line {
+		Tag tag;
+		// value of the clock at last use, smallest is least recently used
+		uint32_t last_use;
+		bool valid, dirty;
+		uint8_t data[LineSize];
+	};
+
+	LineSet();
+
+	/** Find the line holding a tag without counting it as a use
+	 * @return the line or nullptr if the tag is not cached
+	 */
+	const Line *find(const Tag &tag, size_t set) const;
+
+	/** Find the line holding a tag and mark it most recently used
+	 * @return the line or nullptr if the tag is not cached
+	 */
+	Line *use(const Tag &tag, size_t set);
+
+	/** Get the line to replace within a set
+	 * @return an empty line, otherwise the least recently used one
+	 */
+	Line &victim(size_t set);
+
+	/** Let a line hold a tag, unmodified and most recently used
+	 * @note Contents of the line must be written back before
+	 */
+	void assign(Line &line, const Tag &tag);
+
+	inline Line *begin() { return _lines; }
+	inline Line *end() { return _lines + LineCount; }
+	inline const Line *begin() const { return _lines; }
+	inline const Line *end() const { return _lines + LineCount; }
+
+  private:
+	// set i occupies _lines[i * Associativity, (i + 1) * Associativity)
+	Line _lines[LineCount];
+	uint32_t _clock;
+};
+
+template <typename T, size_t L, size_t N, size_t A>
+constexpr size_t LineSet<T, L, N, A>::SetCount;
+
+template <typename T, size_t L, size_t N, size_t A>
+LineSet<T, L, N, A>::LineSet()
+	: _lines{}
+	, _clock{0} {}
+
+template <typename T, size_t L, size_t N, size_t A>
+const typename LineSet<T, L, N, A>::Line *
+LineSet<T, L, N, A>::find(const T &tag, size_t set) const {
+	const Line *lines = &_lines[set * A];
+	for (size_t way = 0; way < A; way++) {
+		if (lines[way].valid && lines[way].tag == tag) {
+			return &lines[way];
+		}
+	}
+	return nullptr;
+}
+
+template <typename T, size_t L, size_t N, size_t A>
+typename LineSet<T, L, N, A>::Line *
+LineSet<T, L, N, A>::use(const T &tag, size_t set) {
+	Line *line = const_cast<Line *>(find(tag, set));
+	if (line) {
+		line->last_use = ++_clock;
+	}
+	return line;
+}
+
+template <typename T, size_t L, size_t N, size_t A>
+typename LineSet<T, L, N, A>::Line &LineSet<T, L, N, A>::victim(size_t set) {
+	Line *lines = &_lines[set * A];
+	Line *victim = &lines[0];
+	for (size_t way = 0; way < A; way++) {
+		Line &candidate = lines[way];
+		// Prefer empty lines, otherwise the least recently used one
+		if (victim->valid &&
+			(!candidate.valid || candidate.last_use < victim->last_use)) {
+			victim = &candidate;
+		}
+	}
+	return *victim;
+}
+
+template <typename T, size_t L, size_t N, size_t A>
+void LineSet<T, L, N, A>::assign(Line &line, const T &tag) {
+	line.tag = tag;
+	line.valid = true;
+	line.dirty = false;
+	line.last_use = ++_clock;
+}
+
+} // namespace helpers
+} // namespace rambock
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "../memory_device.hpp"
+
+// Number of objects that can be held by a LocalCopy at the same time
+#ifndef PIN_TABLE_SIZE
+#define PIN_TABLE_SIZE 16
+#endif
+
+namespace rambock {
+namespace helpers {
+
+/** Local table of external objects currently held by a LocalCopy
+ * Maps a device and address to the local copy of the object there, so that
+ * further copies of the same object alias the first one instead of reading a
+ * stale value from the device. Lookups are linear, the table is meant to hold
+ * the few objects that are accessed at any one time.
+ *
+ * Every thread has a table of its own, so external_ptr and LocalCopy can be
+ * used from several threads without locking. Copies only alias copies made on
+ * the same thread and must be destroyed there.
+ * @note A table must not be shared across threads
+ */
+struct PinTable {
+	/** Find the local copy of an object
+	 * @return the local copy or nullptr if the object is not pinned
+	 */
+	void *find(const MemoryDevice &memory_device, Address address) const;
+
+	/** Registers the local copy of an object
+	 * @return false if the table is full
+	 */
+	bool pin(const MemoryDevice &memory_device, Address address, void *local);
+
+	/** Removes an object registered by pin()
+	 */
+	void unpin(const MemoryDevice &memory_device, Address address);
+
+	/** Get number of pinned objects
+	 */
+	size_t size() const;
+
+	/** Get the table shared by all local copies of the calling thread
+	 */
+	static PinTable &instance();
+
+  private:
+	struct Pin {
+		const MemoryDevice *memory_device;
+		Address address;
+		void *local;
+	};
+
+	Pin *lookup(const MemoryDevice *memory_device, Address address);
+
+	Pin _pins[PIN_TABLE_SIZE];
+};
+
+inline void *PinTable::find(const MemoryDevice &memory_device,
+							Address address) const {
+	for (const Pin &pin : _pins) {
+		if (pin.memory_device == &memory_device && pin.address == address) {
+			return pin.local;
+		}
+	}
+	return nullptr;
+}
+
+inline bool
+PinTable::pin(const MemoryDevice &memory_device, Address address, void *local) {
+	Pin *pin = lookup(nullptr, Address::null());
+	if (!pin) {
+		return false;
+	}
+	*pin = Pin{&memory_device, address, local};
+	return true;
+}
+
+inline void PinTable::unpin(const MemoryDevice &memory_device,
+							Address address) {
+	Pin *pin = lookup(&memory_device, address);
+	if (pin) {
+		*pin = Pin{nullptr, Address::null(), nullptr};
+	}
+}
+
+inline size_t PinTable::size() const {
+	size_t size = 0;
+	for (const Pin &pin : _pins) {
+		size += pin.memory_device != nullptr;
+	}
+	return size;
+}
+
+inline PinTable &PinTable::instance() {
+#ifdef __AVR__
+	// no threads and no thread-local storage
+	static PinTable table{};
+#else
+	static thread_local PinTable table{};
+#endif
+	return table;
+}
+
+inline PinTable::Pin *PinTable::lookup(const MemoryDevice *memory_device,
+									   Address address) {
+	for (Pin &pin : _pins) {
+		if (pin.memory_device == memory_device && pin.address == address) {
+			return &pin;
+		}
+	}
+	return nullptr;
+}
+
+} // namespace helpers
+} // namespace rambock
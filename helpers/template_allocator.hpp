@@ -2,6 +2,12 @@
 
 #include "../allocators/base_allocator.hpp"
 #include "../external_ptr.hpp"
+#include <iterator>
+
+// Local buffer used to initialize arrays, in bytes
+#ifndef FILL_BUFFER_SIZE
+#define FILL_BUFFER_SIZE 256
+#endif
 
 namespace rambock {
 namespace helpers {
@@ -17,8 +23,22 @@ struct TemplateAllocator {
 	template <class T, class... Args>
 	external_ptr<T> make_external(Args &&...args);
 
+	/** Allocates an array of n default constructed objects
+	 */
 	template <class T> external_ptr<T> make_array(size_t n);
 
+	/** Allocates an array of n objects
+	 * @param generator called with each index, returns the object to store
+	 */
+	template <class T, class Generator>
+	external_ptr<T> make_array(size_t n, Generator generator);
+
+	/** Allocates an array holding copies of a range
+	 * @note ForwardIt must allow passing over the range twice
+	 */
+	template <class T, class ForwardIt>
+	external_ptr<T> make_array(ForwardIt first, ForwardIt last);
+
   private:
 	BaseAllocator &_allocator;
 };
@@ -42,6 +62,27 @@ external_ptr<T> TemplateAllocator::make_external(Args &&...args) {
 }
 
 template <class T> external_ptr<T> TemplateAllocator::make_array(size_t n) {
+	// @note T must be TriviallyCopyable and TriviallyConstructable
+	const T value{};
+
+	// Objects made of a single repeated byte are filled on the device
+	const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+	for (size_t i = 1; i < sizeof(T); i++) {
+		if (bytes[i] != bytes[0]) {
+			return make_array<T>(n, [&value](size_t) { return value; });
+		}
+	}
+
+	const Size allocation_size = external_ptr<T>::allocation_size * n;
+	Address address = allocator().allocate(allocation_size);
+	if (address) {
+		allocator().memory_device().fill(address, bytes[0], allocation_size);
+	}
+	return external_ptr<T>{allocator(), address};
+}
+
+template <class T, class Generator>
+external_ptr<T> TemplateAllocator::make_array(size_t n, Generator generator) {
 	const Size allocation_size = external_ptr<T>::allocation_size * n;
 
 	// Request memory before constructing array
@@ -50,15 +91,29 @@ template <class T> external_ptr<T> TemplateAllocator::make_array(size_t n) {
 		return external_ptr<T>{allocator(), Address::null()};
 	}
 
-	// Construct prototype
-	// @note T must be TriviallyCopyable and TriviallyConstructable
-	T value{};
-
-	for (size_t i = 0; i < n; i++) {
-		LocalCopy<T> local_copy{allocator().memory_device(), address, value};
+	// Construct objects in a local buffer and write many of them at once
+	constexpr size_t buffer_count =
+		FILL_BUFFER_SIZE / sizeof(T) > 0 ? FILL_BUFFER_SIZE / sizeof(T) : 1;
+	T buffer[buffer_count];
+	for (size_t done = 0; done < n;) {
+		size_t count = n - done < buffer_count ? n - done : buffer_count;
+		for (size_t i = 0; i < count; i++) {
+			buffer[i] = generator(done + i);
+		}
+		allocator().memory_device().write(
+			address + Size(done * sizeof(T)), buffer, Size(count * sizeof(T)));
+		done += count;
 	}
 	return external_ptr<T>{allocator(), address};
 }
 
+template <class T, class ForwardIt>
+external_ptr<T> TemplateAllocator::make_array(ForwardIt first,
+											   ForwardIt last) {
+	const size_t n = std::distance(first, last);
+	// elements are generated in order, so the index is not needed
+	return make_array<T>(n, [&first](size_t) { return T(*first++); });
+}
+
 } // namespace helpers
-} // namespace rambock
\ No newline at end of file
+} // namespace rambock
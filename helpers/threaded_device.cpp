@@ -0,0 +1,84 @@
+#include "threaded_device.hpp"
+
+rambock::helpers::ThreadedDevice::ThreadedDevice(MemoryDevice &memory_device)
+	: _memory_device{memory_device}
+	, _last_submitted{0}
+	, _last_completed{0}
+	, _stop{false}
+	, _worker{&ThreadedDevice::run, this} {}
+
+rambock::helpers::ThreadedDevice::~ThreadedDevice() {
+	{
+		std::lock_guard<std::mutex> lock{_mutex};
+		_stop = true;
+	}
+	_submitted.notify_one();
+	_worker.join();
+}
+
+rambock::AsyncMemoryDevice::Request
+rambock::helpers::ThreadedDevice::submit_read(
+	void *to, Address from, Size n, Callback callback, void *context) {
+	return enqueue(Job{0, false, to, nullptr, from, n, callback, context});
+}
+
+rambock::AsyncMemoryDevice::Request
+rambock::helpers::ThreadedDevice::submit_write(
+	Address to, const void *from, Size n, Callback callback, void *context) {
+	return enqueue(Job{0, true, nullptr, from, to, n, callback, context});
+}
+
+bool rambock::helpers::ThreadedDevice::poll(Request request) {
+	std::lock_guard<std::mutex> lock{_mutex};
+	// serial number arithmetic keeps working once handles wrap around
+	return int32_t(request - _last_completed) <= 0;
+}
+
+void rambock::helpers::ThreadedDevice::wait(Request request) {
+	std::unique_lock<std::mutex> lock{_mutex};
+	_completed.wait(lock, [this, request] {
+		return int32_t(request - _last_completed) <= 0;
+	});
+}
+
+rambock::AsyncMemoryDevice::Request
+rambock::helpers::ThreadedDevice::enqueue(Job job) {
+	{
+		std::lock_guard<std::mutex> lock{_mutex};
+		// skip zero on overflow
+		if (++_last_submitted == 0) {
+			++_last_submitted;
+		}
+		job.request = _last_submitted;
+		_queue.push_back(job);
+	}
+	_submitted.notify_one();
+	return job.request;
+}
+
+void rambock::helpers::ThreadedDevice::run() {
+	std::unique_lock<std::mutex> lock{_mutex};
+	while (true) {
+		_submitted.wait(lock, [this] { return _stop || !_queue.empty(); });
+		if (_queue.empty()) {
+			// stopped and drained
+			return;
+		}
+		Job job = _queue.front();
+		_queue.pop_front();
+
+		lock.unlock();
+		if (job.is_write) {
+			_memory_device.write(job.address, job.from, job.count);
+		} else {
+			_memory_device.read(job.to, job.address, job.count);
+		}
+		if (job.callback) {
+			job.callback(job.context);
+		}
+		lock.lock();
+
+		_last_completed = job.request;
+		_completed.notify_all();
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../async_memory_device.hpp"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace rambock {
+namespace helpers {
+
+/** Runs a synchronous device on a worker thread
+ * For hosted builds only. Requests are executed in submission order and
+ * callbacks are invoked on the worker thread. While this adapter exists, the
+ * underlying device must not be accessed otherwise.
+ */
+struct ThreadedDevice : public AsyncMemoryDevice {
+	explicit ThreadedDevice(MemoryDevice &memory_device);
+
+	/** Completes all outstanding requests before stopping the worker
+	 */
+	~ThreadedDevice() override;
+
+	Request submit_read(void *to,
+						Address from,
+						Size n,
+						Callback callback,
+						void *context) override;
+	Request submit_write(Address to,
+						 const void *from,
+						 Size n,
+						 Callback callback,
+						 void *context) override;
+	bool poll(Request request) override;
+	void wait(Request request) override;
+
+  private:
+	struct Job {
+		Request request;
+		bool is_write;
+		void *to;
+		const void *from;
+		Address address;
+		Size count;
+		Callback callback;
+		void *context;
+	};
+
+	Request enqueue(Job job);
+	void run();
+
+	MemoryDevice &_memory_device;
+	std::mutex _mutex;
+	std::condition_variable _submitted, _completed;
+	std::deque<Job> _queue;
+	// requests are completed in order, so everything up to _last_completed is
+	// done
+	Request _last_submitted, _last_completed;
+	bool _stop;
+	std::thread _worker;
+};
+
+} // namespace helpers
+} // namespace rambock
@@ -0,0 +1,68 @@
+#include "trace_replay.hpp"
+#include <vector>
+
+namespace {
+
+using rambock::layers::AccessProfiler;
+
+inline uint64_t transactions(const AccessProfiler *bus) {
+	return bus ? bus->reads().calls + bus->writes().calls : 0;
+}
+
+inline uint64_t transferred(const AccessProfiler *bus) {
+	return bus ? bus->reads().bytes + bus->writes().bytes : 0;
+}
+
+} // namespace
+
+rambock::helpers::ReplayResult
+rambock::helpers::replay(const uint8_t *trace,
+						 size_t size,
+						 MemoryDevice &memory_device,
+						 const layers::AccessProfiler *bus,
+						 layers::AccessProfiler::Clock clock) {
+	using Recorder = layers::TraceRecorder;
+
+	ReplayResult result{};
+	std::vector<uint8_t> read_buffer, write_buffer;
+	const uint64_t transactions_before = transactions(bus);
+	const uint64_t transferred_before = transferred(bus);
+	const uint64_t start = clock();
+
+	Recorder::Reader reader{trace, size};
+	Recorder::Record record{};
+	while (reader.next(record)) {
+		switch (record.operation) {
+		case Recorder::READ:
+			if (read_buffer.size() < record.size) {
+				read_buffer.resize(record.size);
+			}
+			memory_device.read(read_buffer.data(), record.address, record.size);
+			break;
+		case Recorder::WRITE:
+			while (write_buffer.size() < record.size) {
+				write_buffer.push_back(uint8_t(write_buffer.size() * 31 + 7));
+			}
+			memory_device.write(
+				record.address, write_buffer.data(), record.size);
+			break;
+		case Recorder::FILL:
+			memory_device.fill(record.address, record.value, record.size);
+			break;
+		case Recorder::COPY:
+			memory_device.copy(record.address, record.source, record.size);
+			break;
+		case Recorder::MOVE:
+			memory_device.move(record.address, record.source, record.size);
+			break;
+		}
+		result.records++;
+		result.bytes += record.size;
+	}
+
+	result.time = clock() - start;
+	result.transactions = transactions(bus) - transactions_before;
+	result.transferred = transferred(bus) - transferred_before;
+	result.complete = reader.done();
+	return result;
+}
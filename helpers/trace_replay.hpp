@@ -0,0 +1,45 @@
+#pragma once
+
+#include "../layers/access_profiler.hpp"
+#include "../layers/trace_recorder.hpp"
+
+namespace rambock {
+namespace helpers {
+
+/** Totals of a replayed trace
+ */
+struct ReplayResult {
+	// records replayed
+	uint64_t records;
+	// bytes read and written by the records
+	uint64_t bytes;
+	// ticks spent replaying
+	uint64_t time;
+	// calls and bytes that reached the profiled device, zero without one
+	uint64_t transactions;
+	uint64_t transferred;
+	// false if the trace ended in a malformed record
+	bool complete;
+};
+
+/** Replays a trace recorded by TraceRecorder against a device
+ * For hosted builds only. Records are issued back to back, recorded
+ * timestamps are ignored. Writes store a fixed pattern rather than the
+ * original data, which the trace does not hold, so replays measure how a
+ * stack of layers handles an access pattern, not what it computes.
+ *
+ * Stacking an AccessProfiler at the bottom of the device and passing it as
+ * bus adds the number of transactions the stack passed on to the result.
+ * Layers buffering writes are not flushed.
+ * @param trace the encoded records
+ * @param size the number of bytes in trace
+ */
+ReplayResult replay(const uint8_t *trace,
+					size_t size,
+					MemoryDevice &memory_device,
+					const layers::AccessProfiler *bus = nullptr,
+					layers::AccessProfiler::Clock clock =
+						&layers::AccessProfiler::nanoseconds);
+
+} // namespace helpers
+} // namespace rambock
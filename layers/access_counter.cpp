@@ -1,15 +1,45 @@
 #include "access_counter.hpp"
 
 void *rambock::layers::AccessCounter::read(void *to, Address from, Size count) {
-	_reads++;
+	_reads.fetch_add(1, std::memory_order_relaxed);
 	return memory_device().read(to, from, count);
 }
 rambock::Address rambock::layers::AccessCounter::write(Address to,
 													   const void *from,
 													   Size count) {
-	_writes++;
+	_writes.fetch_add(1, std::memory_order_relaxed);
 	return memory_device().write(to, from, count);
 }
+void rambock::layers::AccessCounter::readv(const ReadSegment *segments,
+										   size_t n) {
+	_reads.fetch_add(1, std::memory_order_relaxed);
+	memory_device().readv(segments, n);
+}
+void rambock::layers::AccessCounter::writev(const WriteSegment *segments,
+											size_t n) {
+	_writes.fetch_add(1, std::memory_order_relaxed);
+	memory_device().writev(segments, n);
+}
+void rambock::layers::AccessCounter::fill(Address to,
+										  uint8_t value,
+										  Size count) {
+	_writes.fetch_add(1, std::memory_order_relaxed);
+	memory_device().fill(to, value, count);
+}
+void rambock::layers::AccessCounter::copy(Address to,
+										  Address from,
+										  Size count) {
+	_reads.fetch_add(1, std::memory_order_relaxed);
+	_writes.fetch_add(1, std::memory_order_relaxed);
+	memory_device().copy(to, from, count);
+}
+void rambock::layers::AccessCounter::move(Address to,
+										  Address from,
+										  Size count) {
+	_reads.fetch_add(1, std::memory_order_relaxed);
+	_writes.fetch_add(1, std::memory_order_relaxed);
+	memory_device().move(to, from, count);
+}
 rambock::layers::AccessCounter::AccessCounter(MemoryDevice &memory_device)
 	: MemoryLayer(memory_device)
 	, _reads{0}
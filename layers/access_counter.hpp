@@ -1,21 +1,38 @@
 #pragma once
 #include "base_layer.hpp"
+#include <atomic>
 
 namespace rambock {
 namespace layers {
 
+/** Counts accesses passed to the underlying device
+ * Counters are atomic, so the counter may be shared by several threads if
+ * the underlying device allows it.
+ */
 struct AccessCounter : public MemoryLayer {
 	explicit AccessCounter(MemoryDevice &memory_device);
 
 	void *read(void *to, Address from, Size count) override;
 	Address write(Address to, const void *from, Size count) override;
+	// Vectored accesses count as a single access
+	void readv(const ReadSegment *segments, size_t n) override;
+	void writev(const WriteSegment *segments, size_t n) override;
+	// Fills count as a write, copies as a read and a write
+	void fill(Address to, uint8_t value, Size count) override;
+	void copy(Address to, Address from, Size count) override;
+	void move(Address to, Address from, Size count) override;
 
-	inline int reads() const { return _reads; }
-	inline int writes() const { return _writes; }
-	inline void reset() { _reads = _writes = 0; }
+	inline int reads() const { return _reads.load(std::memory_order_relaxed); }
+	inline int writes() const {
+		return _writes.load(std::memory_order_relaxed);
+	}
+	inline void reset() {
+		_reads.store(0, std::memory_order_relaxed);
+		_writes.store(0, std::memory_order_relaxed);
+	}
 
   private:
-	int _reads, _writes;
+	std::atomic<int> _reads, _writes;
 };
 
 } // namespace layers
@@ -0,0 +1,204 @@
+#include "access_profiler.hpp"
+#include <chrono>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+constexpr size_t rambock::layers::AccessProfiler::Histogram::BUCKET_COUNT;
+
+void rambock::layers::AccessProfiler::Histogram::add(uint64_t value) {
+	size_t bucket = 0;
+	while (value && bucket + 1 < BUCKET_COUNT) {
+		value >>= 1;
+		bucket++;
+	}
+	buckets[bucket]++;
+}
+
+uint64_t rambock::layers::AccessProfiler::Histogram::count() const {
+	uint64_t count = 0;
+	for (uint64_t bucket : buckets) {
+		count += bucket;
+	}
+	return count;
+}
+
+rambock::layers::AccessProfiler::AccessProfiler(MemoryDevice &memory_device,
+												Clock clock)
+	: MemoryLayer(memory_device)
+	, _clock{clock}
+	, _snapshot{} {}
+
+void *
+rambock::layers::AccessProfiler::read(void *to, Address from, Size count) {
+	const uint64_t start = _clock();
+	void *result = memory_device().read(to, from, count);
+	record(_snapshot.reads, count, _clock() - start);
+	return result;
+}
+
+rambock::Address rambock::layers::AccessProfiler::write(Address to,
+														const void *from,
+														Size count) {
+	const uint64_t start = _clock();
+	Address result = memory_device().write(to, from, count);
+	record(_snapshot.writes, count, _clock() - start);
+	return result;
+}
+
+void rambock::layers::AccessProfiler::readv(const ReadSegment *segments,
+											size_t n) {
+	uint64_t bytes = 0;
+	for (size_t i = 0; i < n; i++) {
+		bytes += segments[i].count;
+	}
+	const uint64_t start = _clock();
+	memory_device().readv(segments, n);
+	record(_snapshot.reads, bytes, _clock() - start);
+}
+
+void rambock::layers::AccessProfiler::writev(const WriteSegment *segments,
+											 size_t n) {
+	uint64_t bytes = 0;
+	for (size_t i = 0; i < n; i++) {
+		bytes += segments[i].count;
+	}
+	const uint64_t start = _clock();
+	memory_device().writev(segments, n);
+	record(_snapshot.writes, bytes, _clock() - start);
+}
+
+void rambock::layers::AccessProfiler::fill(Address to,
+										   uint8_t value,
+										   Size count) {
+	const uint64_t start = _clock();
+	memory_device().fill(to, value, count);
+	record(_snapshot.writes, count, _clock() - start);
+}
+
+void rambock::layers::AccessProfiler::copy(Address to,
+										   Address from,
+										   Size count) {
+	const uint64_t start = _clock();
+	memory_device().copy(to, from, count);
+	tally(_snapshot.reads, count);
+	record(_snapshot.writes, count, _clock() - start);
+}
+
+void rambock::layers::AccessProfiler::move(Address to,
+										   Address from,
+										   Size count) {
+	const uint64_t start = _clock();
+	memory_device().move(to, from, count);
+	tally(_snapshot.reads, count);
+	record(_snapshot.writes, count, _clock() - start);
+}
+
+void rambock::layers::AccessProfiler::reset() { _snapshot = Snapshot{}; }
+
+void rambock::layers::AccessProfiler::dump(Writer writer,
+										   void *context,
+										   Format format) const {
+	struct Kind {
+		const char *name;
+		const Statistics &statistics;
+	};
+	const Kind kinds[] = {
+		{"read", _snapshot.reads},
+		{"write", _snapshot.writes},
+	};
+
+	char line[128];
+	if (format == CSV) {
+		writer("operation,metric,lower,upper,value", context);
+	}
+	for (const Kind &kind : kinds) {
+		const Statistics &statistics = kind.statistics;
+		if (format == CSV) {
+			const struct {
+				const char *name;
+				uint64_t value;
+			} totals[] = {
+				{"calls", statistics.calls},
+				{"bytes", statistics.bytes},
+				{"time", statistics.time},
+			};
+			for (const auto &total : totals) {
+				snprintf(line,
+						 sizeof(line),
+						 "%s,%s,,,%" PRIu64,
+						 kind.name,
+						 total.name,
+						 total.value);
+				writer(line, context);
+			}
+		} else {
+			snprintf(line,
+					 sizeof(line),
+					 "%ss: %" PRIu64 " calls, %" PRIu64 " bytes, %" PRIu64
+					 " ticks",
+					 kind.name,
+					 statistics.calls,
+					 statistics.bytes,
+					 statistics.time);
+			writer(line, context);
+		}
+
+		const struct {
+			const char *name;
+			const Histogram &histogram;
+		} histograms[] = {
+			{"size", statistics.sizes},
+			{"latency", statistics.latencies},
+		};
+		for (const auto &histogram : histograms) {
+			for (size_t i = 0; i < Histogram::BUCKET_COUNT; i++) {
+				const uint64_t value = histogram.histogram.buckets[i];
+				if (!value) {
+					continue;
+				}
+				// the last bucket has no upper bound
+				char upper[24] = "";
+				if (i + 1 < Histogram::BUCKET_COUNT) {
+					snprintf(upper,
+							 sizeof(upper),
+							 "%" PRIu64,
+							 Histogram::upper_bound(i));
+				} else if (format != CSV) {
+					strcpy(upper, "inf");
+				}
+				snprintf(line,
+						 sizeof(line),
+						 format == CSV ? "%s,%s,%" PRIu64 ",%s,%" PRIu64
+									   : "  %s %s [%" PRIu64 ", %s): %" PRIu64,
+						 kind.name,
+						 histogram.name,
+						 Histogram::lower_bound(i),
+						 upper,
+						 value);
+				writer(line, context);
+			}
+		}
+	}
+}
+
+uint64_t rambock::layers::AccessProfiler::nanoseconds() {
+	return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+						std::chrono::steady_clock::now().time_since_epoch())
+						.count());
+}
+
+void rambock::layers::AccessProfiler::tally(Statistics &statistics,
+											uint64_t bytes) {
+	statistics.calls++;
+	statistics.bytes += bytes;
+	statistics.sizes.add(bytes);
+}
+
+void rambock::layers::AccessProfiler::record(Statistics &statistics,
+											 uint64_t bytes,
+											 uint64_t time) {
+	tally(statistics, bytes);
+	statistics.time += time;
+	statistics.latencies.add(time);
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include "base_layer.hpp"
+
+namespace rambock {
+namespace layers {
+
+/** Records what is passed to the underlying device
+ * Counts calls and bytes of reads and writes and keeps histograms of their
+ * sizes and of the time the underlying device took, measured with a
+ * pluggable clock. Stacked at different depths, profilers show what the
+ * layers in between save.
+ *
+ * Vectored accesses count as a single call, fills as a write, copies and
+ * moves as a read and a write with the time attributed to the write.
+ * @note Not thread-safe
+ */
+struct AccessProfiler : public MemoryLayer {
+	/** Source of timestamps
+	 * @return the current time in ticks of any unit
+	 */
+	using Clock = uint64_t (*)();
+
+	/** Histogram with power-of-two buckets
+	 * Bucket 0 counts zeros, bucket i > 0 counts values in
+	 * [2^(i - 1), 2^i), the last bucket also counts everything larger.
+	 */
+	struct Histogram {
+		static constexpr size_t BUCKET_COUNT = 32;
+
+		void add(uint64_t value);
+		uint64_t count() const;
+
+		static inline uint64_t lower_bound(size_t bucket) {
+			return bucket ? uint64_t(1) << (bucket - 1) : 0;
+		}
+		/** Get the exclusive upper bound of a bucket
+		 * @return UINT64_MAX for the last bucket, which is open-ended
+		 */
+		static inline uint64_t upper_bound(size_t bucket) {
+			return bucket + 1 < BUCKET_COUNT ? uint64_t(1) << bucket
+											 : UINT64_MAX;
+		}
+
+		uint64_t buckets[BUCKET_COUNT];
+	};
+
+	/** Totals and histograms of one kind of access
+	 */
+	struct Statistics {
+		uint64_t calls, bytes, time;
+		Histogram sizes, latencies;
+	};
+
+	struct Snapshot {
+		Statistics reads, writes;
+	};
+
+	enum Format {
+		TEXT,
+		CSV,
+	};
+
+	/** Receives the lines of a dump
+	 * @param line a line without line break
+	 * @param context passed to dump
+	 */
+	using Writer = void (*)(const char *line, void *context);
+
+	/** Constructor
+	 * @param clock source of timestamps, steady_clock nanoseconds by default
+	 */
+	explicit AccessProfiler(MemoryDevice &memory_device,
+							Clock clock = &AccessProfiler::nanoseconds);
+
+	void *read(void *to, Address from, Size count) override;
+	Address write(Address to, const void *from, Size count) override;
+	void readv(const ReadSegment *segments, size_t n) override;
+	void writev(const WriteSegment *segments, size_t n) override;
+	void fill(Address to, uint8_t value, Size count) override;
+	void copy(Address to, Address from, Size count) override;
+	void move(Address to, Address from, Size count) override;
+
+	inline const Statistics &reads() const { return _snapshot.reads; }
+	inline const Statistics &writes() const { return _snapshot.writes; }
+
+	/** Get a copy of all statistics
+	 */
+	inline Snapshot snapshot() const { return _snapshot; }
+	void reset();
+
+	/** Writes all statistics line by line
+	 * Text lists totals and non-empty buckets per kind of access. CSV has
+	 * rows of operation,metric,lower,upper,value with empty bounds for
+	 * totals.
+	 */
+	void dump(Writer writer, void *context, Format format = TEXT) const;
+
+	/** Default clock
+	 * @return nanoseconds of std::chrono::steady_clock
+	 */
+	static uint64_t nanoseconds();
+
+  private:
+	// add an access, with or without the time it took
+	static void tally(Statistics &statistics, uint64_t bytes);
+	static void
+	record(Statistics &statistics, uint64_t bytes, uint64_t time);
+
+	Clock _clock;
+	Snapshot _snapshot;
+};
+
+} // namespace layers
+} // namespace rambock
@@ -1,4 +1,5 @@
 #pragma once
+#include "../async_memory_device.hpp"
 #include "base_layer.hpp"
 #include <memory.h>
 #include <stdlib.h>
@@ -6,17 +7,45 @@
 namespace rambock {
 namespace layers {
 
-template <size_t CacheSize> struct CacheLayer : public MemoryLayer {
+/** Single window write-back cache
+ * Caches CacheSize bytes starting at the most recent missed address.
+ * Modifications are tracked per chunk of ChunkSize bytes, so flushing only
+ * writes back the modified parts of the window, coalescing adjacent chunks
+ * into single writes.
+ */
+template <size_t CacheSize, size_t ChunkSize = 4>
+struct CacheLayer : public MemoryLayer {
+	static_assert(ChunkSize > 0, "ChunkSize must not be zero");
+
 	explicit CacheLayer(MemoryDevice &memory_device);
+	/** Enables prefetch() to overlap fetching with computation
+	 */
+	explicit CacheLayer(AsyncMemoryDevice &memory_device);
 
 	virtual void *read(void *to, Address from, Size count) override;
 	virtual Address write(Address to, const void *from, Size count) override;
+	virtual void readv(const ReadSegment *segments, size_t n) override;
+	virtual void writev(const WriteSegment *segments, size_t n) override;
+	/** Fills the cached part of a range locally and forwards the rest
+	 */
+	virtual void fill(Address to, uint8_t value, Size count) override;
+	virtual void copy(Address to, Address from, Size count) override;
+	/** Moves locally if both ranges are cached, otherwise on the device
+	 */
+	virtual void move(Address to, Address from, Size count) override;
 
 	bool is_cached(Address address, Size count);
 	void flush();
 	void refresh();
 	inline bool dirty() const { return _dirty; }
 
+	/** Replace the cached window with one starting at address
+	 * On an asynchronous device the fetch is only submitted, the next access
+	 * blocks until it completed.
+	 * @param address First address to cache
+	 */
+	void prefetch(Address address);
+
   private:
 	/**
 	 * @brief Cache an address if possible
@@ -29,21 +58,57 @@ template <size_t CacheSize> struct CacheLayer : public MemoryLayer {
 
 	void evict();
 	void fetch(Address address);
+	// wait for an outstanding prefetch, if any
+	void complete();
+
+	static constexpr size_t ChunkCount =
+		(CacheSize + ChunkSize - 1) / ChunkSize;
+
+	/** Mark the chunks covering a range of the window as modified
+	 * @param offset First modified byte relative to the window
+	 * @param count Number of modified bytes
+	 */
+	void mark_dirty(Size offset, Size count);
+	inline bool is_dirty_chunk(size_t chunk) const {
+		return _dirty_chunks[chunk / 8] & (1 << (chunk % 8));
+	}
 
 	Address _begin, _end;
 	uint8_t _cache[CacheSize];
+	// one bit per chunk of the window
+	uint8_t _dirty_chunks[(ChunkCount + 7) / 8];
 	bool _dirty;
+	// nullptr if the underlying device is synchronous
+	AsyncMemoryDevice *_async;
+	// handle of an outstanding prefetch, 0 if there is none
+	AsyncMemoryDevice::Request _pending;
 };
 
-template <size_t S>
-CacheLayer<S>::CacheLayer(MemoryDevice &memory_device)
+template <size_t S, size_t C>
+CacheLayer<S, C>::CacheLayer(MemoryDevice &memory_device)
+	: MemoryLayer(memory_device)
+	, _begin{}
+	, _end{}
+	, _cache{}
+	, _dirty_chunks{}
+	, _dirty{false}
+	, _async{nullptr}
+	, _pending{0} {}
+
+template <size_t S, size_t C>
+CacheLayer<S, C>::CacheLayer(AsyncMemoryDevice &memory_device)
 	: MemoryLayer(memory_device)
 	, _begin{}
 	, _end{}
-	, _cache{} {}
+	, _cache{}
+	, _dirty_chunks{}
+	, _dirty{false}
+	, _async{&memory_device}
+	, _pending{0} {}
 
-template <size_t S>
-void *CacheLayer<S>::read(void *to, Address from, Size count) {
+template <size_t S, size_t C>
+void *CacheLayer<S, C>::read(void *to, Address from, Size count) {
+	complete();
 	void *cached_address = cache(from, count);
 	if (cached_address) {
 		return memcpy(to, cached_address, count);
@@ -54,11 +119,12 @@ void *CacheLayer<S>::read(void *to, Address from, Size count) {
 	}
 }
 
-template <size_t S>
-Address CacheLayer<S>::write(Address to, const void *from, Size count) {
+template <size_t S, size_t C>
+Address CacheLayer<S, C>::write(Address to, const void *from, Size count) {
+	complete();
 	void *cached_address = cache(to, count);
 	if (cached_address) {
-		_dirty = true;
+		mark_dirty(to - _begin, count);
 		memcpy(cached_address, from, count);
 		return to;
 	} else {
@@ -70,7 +136,118 @@ Address CacheLayer<S>::write(Address to, const void *from, Size count) {
 	}
 }
 
-template <size_t S> void *CacheLayer<S>::cache(Address address, Size count) {
+template <size_t S, size_t C>
+void CacheLayer<S, C>::readv(const ReadSegment *segments, size_t n) {
+	complete();
+	// Serve cached segments locally and forward each run of uncached ones
+	// as a single vectored read, without fetching them into the cache
+	size_t first_miss = 0;
+	for (size_t i = 0; i < n; i++) {
+		const ReadSegment &segment = segments[i];
+		if (!is_cached(segment.from, segment.count)) {
+			continue;
+		}
+		if (first_miss < i) {
+			// Flush first to ensure read consistency
+			flush();
+			memory_device().readv(&segments[first_miss], i - first_miss);
+		}
+		memcpy(segment.to, &_cache[segment.from - _begin], segment.count);
+		first_miss = i + 1;
+	}
+	if (first_miss < n) {
+		flush();
+		memory_device().readv(&segments[first_miss], n - first_miss);
+	}
+}
+
+template <size_t S, size_t C>
+void CacheLayer<S, C>::writev(const WriteSegment *segments, size_t n) {
+	complete();
+	// Write cached segments locally and forward each run of uncached ones
+	// as a single vectored write
+	auto forward = [this](const WriteSegment *run, size_t count) {
+		for (size_t i = 0; i < count; i++) {
+			if (_begin < run[i].to + run[i].count && run[i].to < _end) {
+				// Partially cached, evict to keep the cache consistent
+				evict();
+				break;
+			}
+		}
+		memory_device().writev(run, count);
+	};
+
+	size_t first_miss = 0;
+	for (size_t i = 0; i < n; i++) {
+		const WriteSegment &segment = segments[i];
+		if (!is_cached(segment.to, segment.count)) {
+			continue;
+		}
+		if (first_miss < i) {
+			forward(&segments[first_miss], i - first_miss);
+		}
+		if (is_cached(segment.to, segment.count)) {
+			mark_dirty(segment.to - _begin, segment.count);
+			memcpy(&_cache[segment.to - _begin], segment.from, segment.count);
+		} else {
+			// Evicted by the preceding run
+			write(segment.to, segment.from, segment.count);
+		}
+		first_miss = i + 1;
+	}
+	if (first_miss < n) {
+		forward(&segments[first_miss], n - first_miss);
+	}
+}
+
+template <size_t S, size_t C>
+void CacheLayer<S, C>::fill(Address to, uint8_t value, Size count) {
+	complete();
+	const Address end = to + count;
+	if (end <= _begin || _end <= to) {
+		memory_device().fill(to, value, count);
+		return;
+	}
+
+	// fill the overlap in the cache and the parts around it on the device
+	const Address first = to < _begin ? _begin : to;
+	const Address last = end < _end ? end : _end;
+	if (to < first) {
+		memory_device().fill(to, value, first - to);
+	}
+	if (last < end) {
+		memory_device().fill(last, value, end - last);
+	}
+	mark_dirty(first - _begin, last - first);
+	memset(&_cache[first - _begin], value, last - first);
+}
+
+template <size_t S, size_t C>
+void CacheLayer<S, C>::copy(Address to, Address from, Size count) {
+	move(to, from, count);
+}
+
+template <size_t S, size_t C>
+void CacheLayer<S, C>::move(Address to, Address from, Size count) {
+	complete();
+	if (is_cached(to, count) && is_cached(from, count)) {
+		mark_dirty(to - _begin, count);
+		memmove(&_cache[to - _begin], &_cache[from - _begin], count);
+		return;
+	}
+
+	// the device must see modified source bytes and the cache must not hold
+	// stale destination bytes
+	if (_begin < to + count && to < _end) {
+		evict();
+	} else {
+		flush();
+	}
+	memory_device().move(to, from, count);
+}
+
+template <size_t S, size_t C>
+void *CacheLayer<S, C>::cache(Address address, Size count) {
 	if (count > S) {
 		// Too large to cache
 		return nullptr;
@@ -86,34 +263,88 @@ template <size_t S> void *CacheLayer<S>::cache(Address address, Size count) {
 	}
 }
 
-template <size_t S> bool CacheLayer<S>::is_cached(Address address, Size count) {
+template <size_t S, size_t C>
+bool CacheLayer<S, C>::is_cached(Address address, Size count) {
 	Address range_begin = address;
 	Address range_end = address + count;
 	return _begin <= range_begin && range_end <= _end;
 }
 
-template <size_t S> void CacheLayer<S>::evict() {
+template <size_t S, size_t C> void CacheLayer<S, C>::evict() {
 	flush();
 	_begin = _end = Address::null();
 }
 
-template <size_t S> void CacheLayer<S>::fetch(Address address) {
+template <size_t S, size_t C> void CacheLayer<S, C>::fetch(Address address) {
 	_begin = address;
 	_end = address + S;
 	refresh();
 }
 
-template <size_t S> void CacheLayer<S>::flush() {
+template <size_t S, size_t C> void CacheLayer<S, C>::flush() {
+	complete();
 	if (!_dirty)
 		return;
-	memory_device().write(_begin, &_cache, _end - _begin);
+
+	// Write back each run of adjacent dirty chunks at once
+	const Size window_size = _end - _begin;
+	size_t chunk = 0;
+	while (chunk < ChunkCount) {
+		if (!is_dirty_chunk(chunk)) {
+			chunk++;
+			continue;
+		}
+		const size_t first = chunk;
+		while (chunk < ChunkCount && is_dirty_chunk(chunk)) {
+			chunk++;
+		}
+
+		Size begin = first * C;
+		Size end = chunk * C < window_size ? chunk * C : window_size;
+		if (begin < end) {
+			memory_device().write(_begin + begin, &_cache[begin], end - begin);
+		}
+	}
+
+	memset(_dirty_chunks, 0, sizeof(_dirty_chunks));
 	_dirty = false;
 }
 
-template <size_t S> void CacheLayer<S>::refresh() {
+template <size_t S, size_t C> void CacheLayer<S, C>::refresh() {
+	complete();
 	memory_device().read(&_cache, _begin, S);
+	memset(_dirty_chunks, 0, sizeof(_dirty_chunks));
 	_dirty = false;
 }
 
+template <size_t S, size_t C> void CacheLayer<S, C>::prefetch(Address address) {
+	evict();
+	if (!_async) {
+		fetch(address);
+		return;
+	}
+	_begin = address;
+	_end = address + S;
+	_pending = _async->submit_read(&_cache, address, S, nullptr, nullptr);
+}
+
+template <size_t S, size_t C> void CacheLayer<S, C>::complete() {
+	if (!_pending)
+		return;
+	_async->wait(_pending);
+	_pending = 0;
+}
+
+template <size_t S, size_t C>
+void CacheLayer<S, C>::mark_dirty(Size offset, Size count) {
+	if (count == 0)
+		return;
+	const size_t last = (offset + count - 1) / C;
+	for (size_t chunk = offset / C; chunk <= last; chunk++) {
+		_dirty_chunks[chunk / 8] |= static_cast<uint8_t>(1 << (chunk % 8));
+	}
+	_dirty = true;
+}
+
 } // namespace layers
 } // namespace rambock
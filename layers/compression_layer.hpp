@@ -0,0 +1,325 @@
+#pragma once
+#include "../allocators/base_allocator.hpp"
+#include "../helpers/line_set.hpp"
+#include "base_layer.hpp"
+#include <memory.h>
+#include <stdlib.h>
+
+namespace rambock {
+namespace layers {
+
+/** Stores pages of data compressed
+ * Presents PageCount logical pages of PageSize bytes. Every page is stored in
+ * a block of its own taken from an allocator on the backing device, using the
+ * smallest of three encodings:
+ * - ZERO: all bytes are zero, nothing is stored
+ * - RLE: runs of equal bytes as pairs of run length minus one and value
+ * - RAW: the page as is
+ * The page map, holding encoding and location of every page, lives in local
+ * memory.
+ *
+ * Accessed pages are held decompressed in CacheLines local lines with LRU
+ * replacement. Pages are only compressed and written back once evicted or
+ * flushed, and only if they were modified. Accesses fail if a modified page
+ * cannot be stored because the allocator ran out of memory.
+ */
+template <Size PageSize, size_t PageCount, size_t CacheLines = 2>
+struct CompressionLayer : public MemoryLayer {
+	static_assert(PageSize > 0 && PageSize <= 0xffff,
+				  "page sizes must fit into the page map");
+	static_assert(PageCount > 0 && CacheLines > 0,
+				  "at least one page must be stored and cached");
+
+	enum Encoding : uint8_t {
+		ZERO,
+		RLE,
+		RAW,
+	};
+
+	/** Constructor
+	 * @param storage allocator for blocks on the backing device
+	 */
+	explicit CompressionLayer(allocators::BaseAllocator &storage);
+
+	/** Frees all stored pages, modified pages still cached are discarded
+	 */
+	~CompressionLayer() override;
+
+	/** Address just past last addressable byte
+	 */
+	static inline Size size() { return PageSize * PageCount; }
+
+	/** Reads decompressed data
+	 * @return null if the range is out of bounds or a page could not be stored
+	 */
+	virtual void *read(void *to, Address from, Size count) override;
+
+	/** Writes data to be compressed
+	 * @return null if the range is out of bounds or a page could not be stored
+	 */
+	virtual Address write(Address to, const void *from, Size count) override;
+
+	/** Compress and store all modified pages, keep them cached
+	 * @return false if a page could not be stored
+	 */
+	bool flush();
+
+	/** Get number of pages stored with an encoding
+	 * Pages never written count as ZERO.
+	 */
+	size_t page_count(Encoding encoding) const;
+
+	/** Get number of bytes held by blocks on the backing device
+	 */
+	inline Size stored_bytes() const { return _stored_bytes; }
+
+	/** Get number of logical bytes in pages stored at least once
+	 */
+	inline Size used_bytes() const { return _used_pages * PageSize; }
+
+	/** Get ratio of logical to stored bytes of pages stored at least once
+	 * Pages held in the cache count as last stored.
+	 * @return the ratio, or the logical size if nothing is stored
+	 */
+	inline float compression_ratio() const {
+		return float(used_bytes()) / float(_stored_bytes ? _stored_bytes : 1);
+	}
+
+  private:
+	struct Page {
+		Address block;
+		// bytes used by the encoded page and bytes available in its block
+		uint16_t size, capacity;
+		Encoding encoding;
+		bool used;
+	};
+
+	// lines are tagged with the index of the page they hold
+	using Lines = helpers::LineSet<size_t, PageSize, CacheLines>;
+	using Line = typename Lines::Line;
+
+	/**
+	 * @brief Get the line holding a page, loading it on a miss
+	 * @param fetch Whether the page contents are needed
+	 * @return Cached line or nullptr if the evicted page could not be stored
+	 */
+	Line *access(size_t page, bool fetch);
+
+	// decompress a page into a line
+	void load(Line &line);
+	// compress and store a modified line
+	bool store(Line &line);
+
+	/** Encode a page with run-length encoding
+	 * @return the encoded size, or 0 if it would not be smaller than raw
+	 */
+	static Size encode(const uint8_t *page, uint8_t *to);
+	static void decode(const uint8_t *from, Size size, uint8_t *page);
+
+	allocators::BaseAllocator &_storage;
+	Page _pages[PageCount];
+	Lines _lines;
+	Size _stored_bytes;
+	size_t _used_pages;
+	// encoded pages pass through here
+	uint8_t _buffer[PageSize];
+};
+
+template <Size P, size_t N, size_t L>
+CompressionLayer<P, N, L>::CompressionLayer(
+	allocators::BaseAllocator &storage)
+	: MemoryLayer(storage.memory_device())
+	, _storage{storage}
+	, _pages{}
+	, _lines{}
+	, _stored_bytes{0}
+	, _used_pages{0}
+	, _buffer{} {}
+
+template <Size P, size_t N, size_t L>
+CompressionLayer<P, N, L>::~CompressionLayer() {
+	for (Page &page : _pages) {
+		if (page.block) {
+			_storage.free(page.block);
+		}
+	}
+}
+
+template <Size P, size_t N, size_t L>
+void *CompressionLayer<P, N, L>::read(void *to, Address from, Size count) {
+	if (from.value > size() || count > size() - from.value) {
+		return nullptr;
+	}
+	uint8_t *data = static_cast<uint8_t *>(to);
+	for (Size done = 0; done < count;) {
+		const Size offset = (from.value + done) % P;
+		const Size chunk =
+			P - offset < count - done ? P - offset : count - done;
+		Line *line = access((from.value + done) / P, true);
+		if (!line) {
+			return nullptr;
+		}
+		memcpy(data + done, &line->data[offset], chunk);
+		done += chunk;
+	}
+	return to;
+}
+
+template <Size P, size_t N, size_t L>
+Address
+CompressionLayer<P, N, L>::write(Address to, const void *from, Size count) {
+	if (to.value > size() || count > size() - to.value) {
+		return Address::null();
+	}
+	const uint8_t *data = static_cast<const uint8_t *>(from);
+	for (Size done = 0; done < count;) {
+		const Size offset = (to.value + done) % P;
+		const Size chunk =
+			P - offset < count - done ? P - offset : count - done;
+		// Pages that are overwritten completely need not be fetched
+		Line *line = access((to.value + done) / P, chunk != P);
+		if (!line) {
+			return Address::null();
+		}
+		memcpy(&line->data[offset], data + done, chunk);
+		line->dirty = true;
+		done += chunk;
+	}
+	return to;
+}
+
+template <Size P, size_t N, size_t L> bool CompressionLayer<P, N, L>::flush() {
+	bool stored = true;
+	for (Line &line : _lines) {
+		stored = store(line) && stored;
+	}
+	return stored;
+}
+
+template <Size P, size_t N, size_t L>
+size_t CompressionLayer<P, N, L>::page_count(Encoding encoding) const {
+	size_t count = 0;
+	for (const Page &page : _pages) {
+		count += page.encoding == encoding;
+	}
+	return count;
+}
+
+template <Size P, size_t N, size_t L>
+typename CompressionLayer<P, N, L>::Line *
+CompressionLayer<P, N, L>::access(size_t page, bool fetch) {
+	Line *cached = _lines.use(page, 0);
+	if (cached) {
+		return cached;
+	}
+
+	Line &victim = _lines.victim(0);
+	if (!store(victim)) {
+		return nullptr;
+	}
+	_lines.assign(victim, page);
+	if (fetch) {
+		load(victim);
+	}
+	return &victim;
+}
+
+template <Size P, size_t N, size_t L>
+void CompressionLayer<P, N, L>::load(Line &line) {
+	const Page &page = _pages[line.tag];
+	switch (page.encoding) {
+	case ZERO:
+		memset(line.data, 0, P);
+		break;
+	case RLE:
+		memory_device().read(_buffer, page.block, page.size);
+		decode(_buffer, page.size, line.data);
+		break;
+	case RAW:
+		memory_device().read(line.data, page.block, P);
+		break;
+	}
+}
+
+template <Size P, size_t N, size_t L>
+bool CompressionLayer<P, N, L>::store(Line &line) {
+	if (!line.valid || !line.dirty) {
+		return true;
+	}
+	Page &page = _pages[line.tag];
+
+	Encoding encoding = ZERO;
+	Size size = 0;
+	for (Size i = 0; i < P && encoding == ZERO; i++) {
+		encoding = line.data[i] ? RLE : ZERO;
+	}
+	if (encoding == RLE) {
+		size = encode(line.data, _buffer);
+		if (!size) {
+			encoding = RAW;
+			size = P;
+		}
+	}
+
+	// keep the block if the page still fits, release it if none is needed
+	if (page.block && (size > page.capacity || size == 0)) {
+		_storage.free(page.block);
+		_stored_bytes -= page.capacity;
+		page.block = Address::null();
+		page.capacity = 0;
+	}
+	if (size && !page.block) {
+		const Address block = _storage.allocate(size);
+		if (!block) {
+			return false;
+		}
+		page.block = block;
+		page.capacity = uint16_t(size);
+		_stored_bytes += size;
+	}
+	if (size) {
+		memory_device().write(
+			page.block, encoding == RAW ? line.data : _buffer, size);
+	}
+	page.size = uint16_t(size);
+	page.encoding = encoding;
+	if (!page.used) {
+		page.used = true;
+		_used_pages++;
+	}
+	line.dirty = false;
+	return true;
+}
+
+template <Size P, size_t N, size_t L>
+Size CompressionLayer<P, N, L>::encode(const uint8_t *page, uint8_t *to) {
+	Size size = 0;
+	for (Size i = 0; i < P;) {
+		Size run = 1;
+		while (i + run < P && run < 256 && page[i + run] == page[i]) {
+			run++;
+		}
+		if (size + 2 >= P) {
+			// raw is at least as small
+			return 0;
+		}
+		to[size++] = uint8_t(run - 1);
+		to[size++] = page[i];
+		i += run;
+	}
+	return size;
+}
+
+template <Size P, size_t N, size_t L>
+void CompressionLayer<P, N, L>::decode(const uint8_t *from,
+									   Size size,
+									   uint8_t *page) {
+	for (Size i = 0; i + 1 < size; i += 2) {
+		const Size run = Size(from[i]) + 1;
+		memset(page, from[i + 1], run);
+		page += run;
+	}
+}
+
+} // namespace layers
+} // namespace rambock
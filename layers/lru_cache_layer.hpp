@@ -0,0 +1,221 @@
+#pragma once
+#include "../helpers/line_set.hpp"
+#include "base_layer.hpp"
+#include <memory.h>
+#include <stdlib.h>
+
+namespace rambock {
+namespace layers {
+
+/** Set-associative write-back cache with LRU replacement
+ * Holds LineCount lines of LineSize bytes each, grouped into sets of
+ * Associativity lines. Every address maps to exactly one set, within that set
+ * the least recently used line is replaced on a miss. Lines are only written
+ * back if they were modified.
+ *
+ * Accesses larger than the whole cache bypass it.
+ * @note The underlying device must be addressable up to a multiple of LineSize
+ */
+template <size_t LineSize, size_t LineCount, size_t Associativity = LineCount>
+struct LRUCacheLayer : public MemoryLayer {
+	static_assert(LineSize > 0 && LineCount > 0 && Associativity > 0,
+				  "cache geometry must not be empty");
+	static_assert(LineCount % Associativity == 0,
+				  "LineCount must be a multiple of Associativity");
+
+	static constexpr size_t SetCount = LineCount / Associativity;
+	static constexpr Size Capacity = LineSize * LineCount;
+
+	explicit LRUCacheLayer(MemoryDevice &memory_device);
+
+	virtual void *read(void *to, Address from, Size count) override;
+	virtual Address write(Address to, const void *from, Size count) override;
+
+	bool is_cached(Address address, Size count) const;
+	bool dirty() const;
+
+	/** Write back all modified lines, keep them cached
+	 */
+	void flush();
+
+	/** Write back all modified lines and drop them from the cache
+	 */
+	void invalidate();
+
+	inline uint32_t hits() const { return _hits; }
+	inline uint32_t misses() const { return _misses; }
+	inline void reset_statistics() { _hits = _misses = 0; }
+
+  private:
+	// lines are tagged with the first address they cover
+	using Lines = helpers::LineSet<Address, LineSize, LineCount, Associativity>;
+	using Line = typename Lines::Line;
+
+	static inline Address line_address(Address address) {
+		return Address(address.value - address.value % LineSize);
+	}
+
+	static inline size_t set_index(Address line) {
+		return (line.value / LineSize) % SetCount;
+	}
+
+	static inline bool overlaps(const Line &line, Address address, Size count) {
+		return line.valid && line.tag < address + count &&
+			   address < line.tag + LineSize;
+	}
+
+	/**
+	 * @brief Get the line for an address, loading it on a miss
+	 * @param line Line-aligned address
+	 * @param fetch Whether the line contents must be read from the device
+	 * @return Cached line
+	 */
+	Line &access(Address line, bool fetch);
+
+	void write_back(Line &line);
+
+	Lines _lines;
+	uint32_t _hits, _misses;
+};
+
+template <size_t L, size_t N, size_t A>
+LRUCacheLayer<L, N, A>::LRUCacheLayer(MemoryDevice &memory_device)
+	: MemoryLayer(memory_device)
+	, _lines{}
+	, _hits{0}
+	, _misses{0} {}
+
+template <size_t L, size_t N, size_t A>
+void *LRUCacheLayer<L, N, A>::read(void *to, Address from, Size count) {
+	if (count > Capacity) {
+		// Write back overlapping lines first to ensure read consistency
+		for (Line &line : _lines) {
+			if (line.dirty && overlaps(line, from, count)) {
+				write_back(line);
+			}
+		}
+		return memory_device().read(to, from, count);
+	}
+
+	uint8_t *data = static_cast<uint8_t *>(to);
+	Address address = from;
+	Size remaining = count;
+	while (remaining > 0) {
+		Address begin = line_address(address);
+		Size offset = address - begin;
+		Size chunk = L - offset < remaining ? L - offset : remaining;
+
+		Line &line = access(begin, true);
+		memcpy(data, &line.data[offset], chunk);
+
+		data += chunk;
+		address += chunk;
+		remaining -= chunk;
+	}
+	return to;
+}
+
+template <size_t L, size_t N, size_t A>
+Address
+LRUCacheLayer<L, N, A>::write(Address to, const void *from, Size count) {
+	const uint8_t *data = static_cast<const uint8_t *>(from);
+
+	if (count > Capacity) {
+		// Keep resident lines consistent with the device
+		for (Line &line : _lines) {
+			if (!overlaps(line, to, count)) {
+				continue;
+			}
+			Address begin = line.tag < to ? to : line.tag;
+			Address end = to + count < line.tag + L ? to + count : line.tag + L;
+			memcpy(&line.data[begin - line.tag],
+				   data + (begin - to),
+				   end - begin);
+		}
+		return memory_device().write(to, from, count);
+	}
+
+	Address address = to;
+	Size remaining = count;
+	while (remaining > 0) {
+		Address begin = line_address(address);
+		Size offset = address - begin;
+		Size chunk = L - offset < remaining ? L - offset : remaining;
+
+		// Lines that are overwritten completely need not be fetched
+		Line &line = access(begin, chunk != L);
+		memcpy(&line.data[offset], data, chunk);
+		line.dirty = true;
+
+		data += chunk;
+		address += chunk;
+		remaining -= chunk;
+	}
+	return to;
+}
+
+template <size_t L, size_t N, size_t A>
+bool LRUCacheLayer<L, N, A>::is_cached(Address address, Size count) const {
+	Address end = address + count;
+	for (Address line = line_address(address); line < end; line += L) {
+		if (!_lines.find(line, set_index(line))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+template <size_t L, size_t N, size_t A>
+bool LRUCacheLayer<L, N, A>::dirty() const {
+	for (const Line &line : _lines) {
+		if (line.dirty) {
+			return true;
+		}
+	}
+	return false;
+}
+
+template <size_t L, size_t N, size_t A> void LRUCacheLayer<L, N, A>::flush() {
+	for (Line &line : _lines) {
+		write_back(line);
+	}
+}
+
+template <size_t L, size_t N, size_t A>
+void LRUCacheLayer<L, N, A>::invalidate() {
+	for (Line &line : _lines) {
+		write_back(line);
+		line.valid = false;
+	}
+}
+
+template <size_t L, size_t N, size_t A>
+typename LRUCacheLayer<L, N, A>::Line &
+LRUCacheLayer<L, N, A>::access(Address line, bool fetch) {
+	const size_t set = set_index(line);
+	Line *cached = _lines.use(line, set);
+	if (cached) {
+		_hits++;
+		return *cached;
+	}
+
+	_misses++;
+	Line &victim = _lines.victim(set);
+	write_back(victim);
+	_lines.assign(victim, line);
+	if (fetch) {
+		memory_device().read(&victim.data, line, L);
+	}
+	return victim;
+}
+
+template <size_t L, size_t N, size_t A>
+void LRUCacheLayer<L, N, A>::write_back(Line &line) {
+	if (!line.valid || !line.dirty)
+		return;
+	memory_device().write(line.tag, &line.data, L);
+	line.dirty = false;
+}
+
+} // namespace layers
+} // namespace rambock
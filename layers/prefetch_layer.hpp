@@ -0,0 +1,163 @@
+#pragma once
+#include "base_layer.hpp"
+#include <memory.h>
+#include <stdlib.h>
+
+namespace rambock {
+namespace layers {
+
+/** Stride-detecting read-ahead layer
+ * Watches the addresses of incoming reads for sequential or constant-stride
+ * streams. Once a stride has been confirmed, a miss fetches the next depth
+ * elements of the stream into a local buffer of BufferSize bytes in a single
+ * read. The depth grows while prefetched data gets used and backs off when a
+ * prefetched buffer is replaced without a single hit.
+ *
+ * Writes are passed through and keep the buffer consistent.
+ */
+template <size_t BufferSize> struct PrefetchLayer : public MemoryLayer {
+	/** Constructor
+	 * @param memory_device device to prefetch from
+	 * @param end the address just past the last addressable byte, prefetches
+	 * never cross it
+	 * @param max_depth maximum number of elements to read ahead
+	 */
+	PrefetchLayer(MemoryDevice &memory_device, Address end, Size max_depth = 8);
+
+	virtual void *read(void *to, Address from, Size count) override;
+	virtual Address write(Address to, const void *from, Size count) override;
+
+	bool is_buffered(Address address, Size count) const;
+
+	/** Drop all prefetched data and forget the detected stream
+	 */
+	void invalidate();
+
+	inline Size depth() const { return _depth; }
+	inline int32_t stride() const { return _stride; }
+	inline uint32_t hits() const { return _hits; }
+	inline uint32_t misses() const { return _misses; }
+
+  private:
+	// number of consecutive matching strides before prefetching starts
+	static constexpr Size CONFIDENCE_THRESHOLD = 2;
+
+	/** Feed an address into the stride detector
+	 * @param address Address of the current read
+	 */
+	void train(Address address);
+
+	Address _end;
+	Size _max_depth, _depth;
+
+	// stride detector state
+	Address _last;
+	int32_t _stride;
+	Size _confidence;
+
+	// buffered range and whether it served any read since it was fetched
+	Address _begin, _buffer_end;
+	bool _used;
+	uint8_t _buffer[BufferSize];
+
+	uint32_t _hits, _misses;
+};
+
+template <size_t S>
+PrefetchLayer<S>::PrefetchLayer(MemoryDevice &memory_device,
+								Address end,
+								Size max_depth)
+	: MemoryLayer(memory_device)
+	, _end{end}
+	, _max_depth{max_depth}
+	, _depth{1}
+	, _last{}
+	, _stride{0}
+	, _confidence{0}
+	, _begin{}
+	, _buffer_end{}
+	, _used{false}
+	, _buffer{}
+	, _hits{0}
+	, _misses{0} {}
+
+template <size_t S>
+void *PrefetchLayer<S>::read(void *to, Address from, Size count) {
+	if (is_buffered(from, count)) {
+		_hits++;
+		_used = true;
+		train(from);
+		return memcpy(to, &_buffer[from - _begin], count);
+	}
+
+	_misses++;
+	train(from);
+	if (count > S || _confidence < CONFIDENCE_THRESHOLD || _stride <= 0 ||
+		_max_depth == 0) {
+		// No stream to follow, do not speculate
+		return memory_device().read(to, from, count);
+	}
+
+	// Adapt depth to how useful the previous prefetch was
+	if (_begin != _buffer_end) {
+		if (_used) {
+			_depth = 2 * _depth < _max_depth ? 2 * _depth : _max_depth;
+		} else if (_depth > 1) {
+			_depth /= 2;
+		}
+	}
+
+	Size span = Size(_stride) * _depth + count;
+	if (span > S) {
+		span = S;
+	}
+	if (from + span > _end) {
+		span = _end > from + count ? _end - from : count;
+	}
+
+	memory_device().read(&_buffer, from, span);
+	_begin = from;
+	_buffer_end = from + span;
+	_used = false;
+	return memcpy(to, &_buffer, count);
+}
+
+template <size_t S>
+Address PrefetchLayer<S>::write(Address to, const void *from, Size count) {
+	// Patch the overlapping part of the buffer
+	Address begin = _begin < to ? to : _begin;
+	Address end = to + count < _buffer_end ? to + count : _buffer_end;
+	if (begin < end) {
+		memcpy(&_buffer[begin - _begin],
+			   static_cast<const uint8_t *>(from) + (begin - to),
+			   end - begin);
+	}
+	return memory_device().write(to, from, count);
+}
+
+template <size_t S>
+bool PrefetchLayer<S>::is_buffered(Address address, Size count) const {
+	return _begin <= address && address + count <= _buffer_end;
+}
+
+template <size_t S> void PrefetchLayer<S>::invalidate() {
+	_begin = _buffer_end = Address::null();
+	_used = false;
+	_stride = 0;
+	_confidence = 0;
+	_depth = 1;
+}
+
+template <size_t S> void PrefetchLayer<S>::train(Address address) {
+	int32_t stride = int32_t(address.value - _last.value);
+	if (stride == _stride) {
+		_confidence++;
+	} else {
+		_stride = stride;
+		_confidence = 0;
+	}
+	_last = address;
+}
+
+} // namespace layers
+} // namespace rambock
@@ -0,0 +1,180 @@
+#pragma once
+#include "base_layer.hpp"
+#include "lru_cache_layer.hpp"
+#include <memory>
+#include <mutex>
+
+namespace rambock {
+namespace layers {
+
+/** Write-back cache that can be accessed from several threads
+ * For hosted builds only. Lines of LineSize bytes are dealt out to ShardCount
+ * shards by address, each an LRUCacheLayer of LinesPerShard lines behind a
+ * lock of its own. Accesses to lines of different shards proceed in
+ * parallel, so threads working on independent address ranges rarely wait for
+ * each other.
+ *
+ * Accesses are split into lines and every line is read or written while
+ * holding its shard's lock, so accesses are atomic per line only.
+ * @note The underlying device must allow concurrent accesses to different
+ * lines, other accesses to it are not coordinated with the cache
+ */
+template <size_t LineSize, size_t LinesPerShard, size_t ShardCount = 8>
+struct ShardedCacheLayer : public MemoryLayer {
+	static_assert(LineSize > 0 && LinesPerShard > 0 && ShardCount > 0,
+				  "cache geometry must not be empty");
+
+	explicit ShardedCacheLayer(MemoryDevice &memory_device);
+
+	virtual void *read(void *to, Address from, Size count) override;
+	virtual Address write(Address to, const void *from, Size count) override;
+
+	bool is_cached(Address address, Size count);
+
+	/** Write back all modified lines, keep them cached
+	 */
+	void flush();
+
+	/** Write back all modified lines and drop them from the cache
+	 */
+	void invalidate();
+
+	uint32_t hits();
+	uint32_t misses();
+	void reset_statistics();
+
+  private:
+	/** LRU cache of one shard, behind a lock of its own
+	 */
+	struct Shard {
+		explicit Shard(MemoryDevice &memory_device)
+			: cache{memory_device} {}
+
+		std::mutex mutex;
+		LRUCacheLayer<LineSize, LinesPerShard> cache;
+	};
+
+	static inline Address line_address(Address address) {
+		return Address(address.value - address.value % LineSize);
+	}
+
+	inline Shard &shard_of(Address line) {
+		return *_shards[(line.value / LineSize) % ShardCount];
+	}
+
+	// shards hold a mutex and a reference, so they are built one by one
+	std::unique_ptr<Shard> _shards[ShardCount];
+};
+
+template <size_t L, size_t N, size_t S>
+ShardedCacheLayer<L, N, S>::ShardedCacheLayer(MemoryDevice &memory_device)
+	: MemoryLayer(memory_device) {
+	for (std::unique_ptr<Shard> &shard : _shards) {
+		shard.reset(new Shard{memory_device});
+	}
+}
+
+template <size_t L, size_t N, size_t S>
+void *ShardedCacheLayer<L, N, S>::read(void *to, Address from, Size count) {
+	uint8_t *data = static_cast<uint8_t *>(to);
+	Address address = from;
+	Size remaining = count;
+	while (remaining > 0) {
+		Size offset = address - line_address(address);
+		Size chunk = L - offset < remaining ? L - offset : remaining;
+
+		Shard &shard = shard_of(address);
+		{
+			std::lock_guard<std::mutex> lock{shard.mutex};
+			shard.cache.read(data, address, chunk);
+		}
+
+		data += chunk;
+		address += chunk;
+		remaining -= chunk;
+	}
+	return to;
+}
+
+template <size_t L, size_t N, size_t S>
+Address
+ShardedCacheLayer<L, N, S>::write(Address to, const void *from, Size count) {
+	const uint8_t *data = static_cast<const uint8_t *>(from);
+	Address address = to;
+	Size remaining = count;
+	while (remaining > 0) {
+		Size offset = address - line_address(address);
+		Size chunk = L - offset < remaining ? L - offset : remaining;
+
+		Shard &shard = shard_of(address);
+		{
+			std::lock_guard<std::mutex> lock{shard.mutex};
+			shard.cache.write(address, data, chunk);
+		}
+
+		data += chunk;
+		address += chunk;
+		remaining -= chunk;
+	}
+	return to;
+}
+
+template <size_t L, size_t N, size_t S>
+bool ShardedCacheLayer<L, N, S>::is_cached(Address address, Size count) {
+	Address end = address + count;
+	for (Address begin = line_address(address); begin < end; begin += L) {
+		Shard &shard = shard_of(begin);
+		std::lock_guard<std::mutex> lock{shard.mutex};
+		if (!shard.cache.is_cached(begin, L)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+template <size_t L, size_t N, size_t S>
+void ShardedCacheLayer<L, N, S>::flush() {
+	for (std::unique_ptr<Shard> &shard : _shards) {
+		std::lock_guard<std::mutex> lock{shard->mutex};
+		shard->cache.flush();
+	}
+}
+
+template <size_t L, size_t N, size_t S>
+void ShardedCacheLayer<L, N, S>::invalidate() {
+	for (std::unique_ptr<Shard> &shard : _shards) {
+		std::lock_guard<std::mutex> lock{shard->mutex};
+		shard->cache.invalidate();
+	}
+}
+
+template <size_t L, size_t N, size_t S>
+uint32_t ShardedCacheLayer<L, N, S>::hits() {
+	uint32_t hits = 0;
+	for (std::unique_ptr<Shard> &shard : _shards) {
+		std::lock_guard<std::mutex> lock{shard->mutex};
+		hits += shard->cache.hits();
+	}
+	return hits;
+}
+
+template <size_t L, size_t N, size_t S>
+uint32_t ShardedCacheLayer<L, N, S>::misses() {
+	uint32_t misses = 0;
+	for (std::unique_ptr<Shard> &shard : _shards) {
+		std::lock_guard<std::mutex> lock{shard->mutex};
+		misses += shard->cache.misses();
+	}
+	return misses;
+}
+
+template <size_t L, size_t N, size_t S>
+void ShardedCacheLayer<L, N, S>::reset_statistics() {
+	for (std::unique_ptr<Shard> &shard : _shards) {
+		std::lock_guard<std::mutex> lock{shard->mutex};
+		shard->cache.reset_statistics();
+	}
+}
+
+} // namespace layers
+} // namespace rambock
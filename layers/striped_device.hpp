@@ -0,0 +1,247 @@
+#pragma once
+
+#include "../async_memory_device.hpp"
+#include "../memory_device.hpp"
+
+// Number of stripes passed to a synchronous device per vectored access
+#ifndef STRIPE_BATCH_SIZE
+#define STRIPE_BATCH_SIZE 8
+#endif
+
+namespace rambock {
+namespace layers {
+
+/** Presents several devices as a single address space
+ * Devices are either concatenated, one after another, or striped: the address
+ * space is cut into stripes that are dealt out to the devices in turn, so
+ * sequential accesses spread evenly over all of them.
+ *
+ * Requests are split into one piece per stripe. Synchronous devices receive
+ * all pieces of a request at once through readv/writev, which vectored
+ * backends merge into sequential transfers. If Device is asynchronous, pieces
+ * are submitted in address order with one request in flight per device, so
+ * transfers to different devices overlap.
+ *
+ * @tparam DeviceCount number of underlying devices
+ * @tparam Device common type of the devices
+ */
+template <size_t DeviceCount, typename Device = MemoryDevice>
+struct StripedDevice : public MemoryDevice {
+	static_assert(DeviceCount > 0, "at least one device is needed");
+
+	/** Constructor
+	 * @param devices the devices to spread data over
+	 * @param device_size the number of bytes to use on every device
+	 * @param stripe_size bytes per stripe, 0 to concatenate the devices
+	 */
+	StripedDevice(Device *const (&devices)[DeviceCount],
+				  Size device_size,
+				  Size stripe_size = 0);
+
+	/** Address just past last addressable byte
+	 */
+	inline Size size() const { return _device_size * DeviceCount; }
+
+	/** Reads from the devices
+	 * @return null if the range is out of bounds
+	 */
+	void *read(void *to, Address from, Size n) override;
+
+	/** Writes to the devices
+	 * @return null if the range is out of bounds
+	 */
+	Address write(Address to, const void *from, Size n) override;
+
+	void fill(Address to, uint8_t value, Size n) override;
+
+  private:
+	/** Part of a request lying on a single device
+	 */
+	struct Piece {
+		size_t device;
+		Address address;
+		Size count;
+	};
+
+	// locate the piece starting at an address, at most n bytes long
+	Piece piece(Address address, Size n) const;
+
+	inline bool contains(Address address, Size n) const {
+		return address.value <= size() && n <= size() - address.value;
+	}
+
+	// split a request for synchronous or asynchronous devices
+	void read_pieces(MemoryDevice *, uint8_t *to, Address from, Size n);
+	void read_pieces(AsyncMemoryDevice *, uint8_t *to, Address from, Size n);
+	void
+	write_pieces(MemoryDevice *, Address to, const uint8_t *from, Size n);
+	void write_pieces(AsyncMemoryDevice *,
+					  Address to,
+					  const uint8_t *from,
+					  Size n);
+
+	Device *_devices[DeviceCount];
+	Size _device_size;
+	Size _stripe_size;
+};
+
+template <size_t N, typename D>
+StripedDevice<N, D>::StripedDevice(D *const (&devices)[N],
+								   Size device_size,
+								   Size stripe_size)
+	: _devices{}
+	// only whole stripes are used
+	, _device_size{stripe_size ? device_size - device_size % stripe_size
+							   : device_size}
+	, _stripe_size{stripe_size} {
+	for (size_t i = 0; i < N; i++) {
+		_devices[i] = devices[i];
+	}
+}
+
+template <size_t N, typename D>
+void *StripedDevice<N, D>::read(void *to, Address from, Size n) {
+	if (!contains(from, n)) {
+		return nullptr;
+	}
+	read_pieces(_devices[0], static_cast<uint8_t *>(to), from, n);
+	return to;
+}
+
+template <size_t N, typename D>
+Address StripedDevice<N, D>::write(Address to, const void *from, Size n) {
+	if (!contains(to, n)) {
+		return Address::null();
+	}
+	write_pieces(_devices[0], to, static_cast<const uint8_t *>(from), n);
+	return to;
+}
+
+template <size_t N, typename D>
+void StripedDevice<N, D>::fill(Address to, uint8_t value, Size n) {
+	if (!contains(to, n)) {
+		return;
+	}
+	for (Size done = 0; done < n;) {
+		const Piece part = piece(to + done, n - done);
+		_devices[part.device]->fill(part.address, value, part.count);
+		done += part.count;
+	}
+}
+
+template <size_t N, typename D>
+typename StripedDevice<N, D>::Piece
+StripedDevice<N, D>::piece(Address address, Size n) const {
+	Piece part{};
+	Size room = 0;
+	if (_stripe_size == 0) {
+		part.device = address.value / _device_size;
+		part.address = Address(address.value % _device_size);
+		room = _device_size - part.address.value;
+	} else {
+		const Size stripe = address.value / _stripe_size;
+		const Size offset = address.value % _stripe_size;
+		part.device = stripe % N;
+		part.address = Address(stripe / N * _stripe_size + offset);
+		room = _stripe_size - offset;
+	}
+	part.count = n < room ? n : room;
+	return part;
+}
+
+template <size_t N, typename D>
+void StripedDevice<N, D>::read_pieces(MemoryDevice *,
+									  uint8_t *to,
+									  Address from,
+									  Size n) {
+	// visit the pieces of one device after another
+	for (size_t device = 0; device < N; device++) {
+		ReadSegment batch[STRIPE_BATCH_SIZE];
+		size_t count = 0;
+		for (Size done = 0; done < n;) {
+			const Piece part = piece(from + done, n - done);
+			if (part.device == device) {
+				batch[count++] =
+					ReadSegment{to + done, part.address, part.count};
+			}
+			done += part.count;
+			if (count == STRIPE_BATCH_SIZE || (count && done == n)) {
+				_devices[device]->readv(batch, count);
+				count = 0;
+			}
+		}
+	}
+}
+
+template <size_t N, typename D>
+void StripedDevice<N, D>::read_pieces(AsyncMemoryDevice *,
+									  uint8_t *to,
+									  Address from,
+									  Size n) {
+	AsyncMemoryDevice::Request pending[N] = {};
+	for (Size done = 0; done < n;) {
+		const Piece part = piece(from + done, n - done);
+		D &device = *_devices[part.device];
+		if (pending[part.device]) {
+			device.wait(pending[part.device]);
+		}
+		pending[part.device] = device.submit_read(
+			to + done, part.address, part.count, nullptr, nullptr);
+		done += part.count;
+	}
+	for (size_t device = 0; device < N; device++) {
+		if (pending[device]) {
+			_devices[device]->wait(pending[device]);
+		}
+	}
+}
+
+template <size_t N, typename D>
+void StripedDevice<N, D>::write_pieces(MemoryDevice *,
+									   Address to,
+									   const uint8_t *from,
+									   Size n) {
+	// visit the pieces of one device after another
+	for (size_t device = 0; device < N; device++) {
+		WriteSegment batch[STRIPE_BATCH_SIZE];
+		size_t count = 0;
+		for (Size done = 0; done < n;) {
+			const Piece part = piece(to + done, n - done);
+			if (part.device == device) {
+				batch[count++] =
+					WriteSegment{part.address, from + done, part.count};
+			}
+			done += part.count;
+			if (count == STRIPE_BATCH_SIZE || (count && done == n)) {
+				_devices[device]->writev(batch, count);
+				count = 0;
+			}
+		}
+	}
+}
+
+template <size_t N, typename D>
+void StripedDevice<N, D>::write_pieces(AsyncMemoryDevice *,
+									   Address to,
+									   const uint8_t *from,
+									   Size n) {
+	AsyncMemoryDevice::Request pending[N] = {};
+	for (Size done = 0; done < n;) {
+		const Piece part = piece(to + done, n - done);
+		D &device = *_devices[part.device];
+		if (pending[part.device]) {
+			device.wait(pending[part.device]);
+		}
+		pending[part.device] = device.submit_write(
+			part.address, from + done, part.count, nullptr, nullptr);
+		done += part.count;
+	}
+	for (size_t device = 0; device < N; device++) {
+		if (pending[device]) {
+			_devices[device]->wait(pending[device]);
+		}
+	}
+}
+
+} // namespace layers
+} // namespace rambock
@@ -0,0 +1,191 @@
+#include "trace_recorder.hpp"
+
+static_assert(TRACE_BUFFER_SIZE >= 32, "buffer must hold a whole record");
+
+namespace {
+
+// map signed differences to small unsigned values
+inline uint64_t zigzag(int64_t value) {
+	return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+}
+
+inline int64_t unzigzag(uint64_t value) {
+	return int64_t(value >> 1) ^ -int64_t(value & 1);
+}
+
+} // namespace
+
+constexpr size_t rambock::layers::TraceRecorder::MAX_RECORD_SIZE;
+
+rambock::layers::TraceRecorder::Reader::Reader(const uint8_t *data,
+											   size_t size)
+	: _data{data}
+	, _size{size}
+	, _position{0}
+	, _end{Address::null()}
+	, _time{0}
+	, _malformed{false} {}
+
+bool rambock::layers::TraceRecorder::Reader::next(Record &record) {
+	if (_malformed || _position >= _size) {
+		return false;
+	}
+	_malformed = !decode(record);
+	return !_malformed;
+}
+
+bool rambock::layers::TraceRecorder::Reader::decode(Record &record) {
+	if (_data[_position] > MOVE) {
+		return false;
+	}
+	record = Record{};
+	record.operation = Operation(_data[_position++]);
+
+	uint64_t address = 0, size = 0, time = 0;
+	if (!read_varint(address) || !read_varint(size)) {
+		return false;
+	}
+	record.address = Address(uint32_t(int64_t(_end.value) + unzigzag(address)));
+	record.size = Size(size);
+
+	if (record.operation == FILL) {
+		if (_position >= _size) {
+			return false;
+		}
+		record.value = _data[_position++];
+	} else if (record.operation == COPY || record.operation == MOVE) {
+		uint64_t source = 0;
+		if (!read_varint(source)) {
+			return false;
+		}
+		record.source =
+			Address(uint32_t(int64_t(record.address.value) + unzigzag(source)));
+	}
+
+	if (!read_varint(time)) {
+		return false;
+	}
+	_time += time;
+	record.time = _time;
+	_end = record.address + record.size;
+	return true;
+}
+
+bool rambock::layers::TraceRecorder::Reader::read_varint(uint64_t &value) {
+	value = 0;
+	for (unsigned shift = 0; shift < 64 && _position < _size; shift += 7) {
+		const uint8_t byte = _data[_position++];
+		value |= uint64_t(byte & 0x7f) << shift;
+		if (!(byte & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+rambock::layers::TraceRecorder::TraceRecorder(MemoryDevice &memory_device,
+											  Sink sink,
+											  void *context,
+											  AccessProfiler::Clock clock)
+	: MemoryLayer(memory_device)
+	, _sink{sink}
+	, _context{context}
+	, _clock{clock}
+	, _records{0}
+	, _end{Address::null()}
+	, _time{clock()}
+	, _buffer{}
+	, _used{0} {}
+
+rambock::layers::TraceRecorder::~TraceRecorder() { flush(); }
+
+void *
+rambock::layers::TraceRecorder::read(void *to, Address from, Size count) {
+	append(READ, from, count);
+	return memory_device().read(to, from, count);
+}
+
+rambock::Address rambock::layers::TraceRecorder::write(Address to,
+													   const void *from,
+													   Size count) {
+	append(WRITE, to, count);
+	return memory_device().write(to, from, count);
+}
+
+void rambock::layers::TraceRecorder::readv(const ReadSegment *segments,
+										   size_t n) {
+	for (size_t i = 0; i < n; i++) {
+		append(READ, segments[i].from, segments[i].count);
+	}
+	memory_device().readv(segments, n);
+}
+
+void rambock::layers::TraceRecorder::writev(const WriteSegment *segments,
+											size_t n) {
+	for (size_t i = 0; i < n; i++) {
+		append(WRITE, segments[i].to, segments[i].count);
+	}
+	memory_device().writev(segments, n);
+}
+
+void rambock::layers::TraceRecorder::fill(Address to,
+										  uint8_t value,
+										  Size count) {
+	append(FILL, to, count, Address::null(), value);
+	memory_device().fill(to, value, count);
+}
+
+void rambock::layers::TraceRecorder::copy(Address to,
+										  Address from,
+										  Size count) {
+	append(COPY, to, count, from);
+	memory_device().copy(to, from, count);
+}
+
+void rambock::layers::TraceRecorder::move(Address to,
+										  Address from,
+										  Size count) {
+	append(MOVE, to, count, from);
+	memory_device().move(to, from, count);
+}
+
+void rambock::layers::TraceRecorder::flush() {
+	if (_used) {
+		_sink(_buffer, _used, _context);
+		_used = 0;
+	}
+}
+
+void rambock::layers::TraceRecorder::append(Operation operation,
+											Address address,
+											Size size,
+											Address source,
+											uint8_t value) {
+	if (sizeof(_buffer) - _used < MAX_RECORD_SIZE) {
+		flush();
+	}
+	const uint64_t now = _clock();
+
+	_buffer[_used++] = operation;
+	append_varint(zigzag(int64_t(address.value) - int64_t(_end.value)));
+	append_varint(size);
+	if (operation == FILL) {
+		_buffer[_used++] = value;
+	} else if (operation == COPY || operation == MOVE) {
+		append_varint(
+			zigzag(int64_t(source.value) - int64_t(address.value)));
+	}
+	append_varint(now - _time);
+
+	_time = now;
+	_end = address + size;
+	_records++;
+}
+
+void rambock::layers::TraceRecorder::append_varint(uint64_t value) {
+	while (value >= 0x80) {
+		_buffer[_used++] = uint8_t(value | 0x80);
+		value >>= 7;
+	}
+	_buffer[_used++] = uint8_t(value);
+}
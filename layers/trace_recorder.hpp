@@ -0,0 +1,132 @@
+#pragma once
+#include "access_profiler.hpp"
+#include "base_layer.hpp"
+
+// Local buffer holding encoded records until they are passed on, in bytes
+#ifndef TRACE_BUFFER_SIZE
+#define TRACE_BUFFER_SIZE 256
+#endif
+
+namespace rambock {
+namespace layers {
+
+/** Logs every access to a compact binary stream
+ * Each access is encoded as a record of its operation, addresses, size and
+ * timestamp and passed to a sink in chunks of up to TRACE_BUFFER_SIZE bytes.
+ * Addresses are stored relative to the end of the previous access and times
+ * relative to the previous record, both as variable length integers, so
+ * sequential accesses take a few bytes each. Reader decodes the stream again,
+ * for example to replay it with helpers::replay.
+ *
+ * Vectored accesses are recorded as one record per segment.
+ * @note Not thread-safe
+ */
+struct TraceRecorder : public MemoryLayer {
+	enum Operation : uint8_t {
+		READ,
+		WRITE,
+		FILL,
+		COPY,
+		MOVE,
+	};
+
+	/** A single access
+	 * source is only set for COPY and MOVE, value only for FILL.
+	 */
+	struct Record {
+		Operation operation;
+		Address address;
+		Address source;
+		Size size;
+		uint8_t value;
+		// ticks since the recorder was constructed
+		uint64_t time;
+	};
+
+	/** Decodes a recorded stream
+	 */
+	struct Reader {
+		Reader(const uint8_t *data, size_t size);
+
+		/** Decodes the next record
+		 * @return false at the end of the stream or if it is malformed
+		 */
+		bool next(Record &record);
+
+		/** Check whether the whole stream was decoded without errors
+		 */
+		inline bool done() const { return !_malformed && _position == _size; }
+
+	  private:
+		bool decode(Record &record);
+		bool read_varint(uint64_t &value);
+
+		const uint8_t *_data;
+		size_t _size, _position;
+		Address _end;
+		uint64_t _time;
+		bool _malformed;
+	};
+
+	/** Receives encoded records
+	 * @param data the encoded records
+	 * @param size the number of bytes
+	 * @param context passed to the constructor
+	 */
+	using Sink = void (*)(const uint8_t *data, size_t size, void *context);
+
+	/** Constructor
+	 * @param sink called with encoded records
+	 * @param context passed to sink
+	 * @param clock source of timestamps
+	 */
+	TraceRecorder(MemoryDevice &memory_device,
+				  Sink sink,
+				  void *context,
+				  AccessProfiler::Clock clock = &AccessProfiler::nanoseconds);
+
+	/** Passes remaining records to the sink
+	 */
+	~TraceRecorder() override;
+
+	void *read(void *to, Address from, Size count) override;
+	Address write(Address to, const void *from, Size count) override;
+	void readv(const ReadSegment *segments, size_t n) override;
+	void writev(const WriteSegment *segments, size_t n) override;
+	void fill(Address to, uint8_t value, Size count) override;
+	void copy(Address to, Address from, Size count) override;
+	void move(Address to, Address from, Size count) override;
+
+	/** Passes buffered records to the sink
+	 */
+	void flush();
+
+	/** Get number of records written so far
+	 */
+	inline uint64_t records() const { return _records; }
+
+  private:
+	// largest encoding of a record
+	static constexpr size_t MAX_RECORD_SIZE = 1 + 5 + 5 + 1 + 5 + 10;
+
+	void append(Operation operation,
+				Address address,
+				Size size,
+				Address source = Address::null(),
+				uint8_t value = 0);
+	void append_varint(uint64_t value);
+
+	Sink _sink;
+	void *_context;
+	AccessProfiler::Clock _clock;
+	uint64_t _records;
+	// addresses and times are encoded relative to these
+	Address _end;
+	uint64_t _time;
+
+	uint8_t _buffer[TRACE_BUFFER_SIZE];
+	size_t _used;
+};
+
+} // namespace layers
+} // namespace rambock
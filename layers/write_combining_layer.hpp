@@ -0,0 +1,188 @@
+#pragma once
+#include "base_layer.hpp"
+#include <memory.h>
+#include <stdlib.h>
+
+namespace rambock {
+namespace layers {
+
+/** Write-combining buffer
+ * Holds back writes and merges overlapping or adjacent ones into a single
+ * range, so bursts of small writes to neighboring addresses reach the device
+ * as one sequential transfer.
+ * Pending data is drained when the buffer runs out of space or ranges, on
+ * flush() and before reads that cannot be served from pending data alone.
+ *
+ * @tparam BufferSize number of bytes that may be pending at once
+ * @tparam MaxRanges number of disjoint ranges that may be pending at once
+ */
+template <size_t BufferSize, size_t MaxRanges = 8>
+struct WriteCombiningLayer : public MemoryLayer {
+	static_assert(BufferSize > 0 && MaxRanges > 0,
+				  "buffer must hold at least one range");
+
+	explicit WriteCombiningLayer(MemoryDevice &memory_device);
+
+	virtual void *read(void *to, Address from, Size count) override;
+	virtual Address write(Address to, const void *from, Size count) override;
+
+	/** Write all pending ranges to the device
+	 */
+	void flush();
+
+	inline size_t pending_ranges() const { return _count; }
+	inline Size pending_bytes() const { return _used; }
+
+  private:
+	struct Range {
+		Address begin;
+		Size size;
+
+		inline Address end() const { return begin + size; }
+	};
+
+	/** Offset of a range's data in the buffer
+	 * Data of all ranges is stored back to back in address order.
+	 * @param index Index of the range
+	 * @return Offset into _data
+	 */
+	Size offset_of(size_t index) const;
+
+	/** Merge a write into the pending ranges
+	 * @return whether there was enough space to hold the write
+	 */
+	bool combine(Address to, const uint8_t *from, Size count);
+
+	Range _ranges[MaxRanges];
+	size_t _count;
+	Size _used;
+	uint8_t _data[BufferSize];
+};
+
+template <size_t S, size_t R>
+WriteCombiningLayer<S, R>::WriteCombiningLayer(MemoryDevice &memory_device)
+	: MemoryLayer(memory_device)
+	, _ranges{}
+	, _count{0}
+	, _used{0}
+	, _data{} {}
+
+template <size_t S, size_t R>
+void *WriteCombiningLayer<S, R>::read(void *to, Address from, Size count) {
+	for (size_t i = 0; i < _count; i++) {
+		const Range &range = _ranges[i];
+		if (range.begin <= from && from + count <= range.end()) {
+			// Served completely from pending data
+			return memcpy(
+				to, &_data[offset_of(i) + (from - range.begin)], count);
+		} else if (range.begin < from + count && from < range.end()) {
+			// The device is needed, so it must see pending data first
+			flush();
+			break;
+		}
+	}
+	return memory_device().read(to, from, count);
+}
+
+template <size_t S, size_t R>
+Address
+WriteCombiningLayer<S, R>::write(Address to, const void *from, Size count) {
+	const uint8_t *data = static_cast<const uint8_t *>(from);
+	if (count > S) {
+		// Too large to buffer, keep order by draining first
+		flush();
+		return memory_device().write(to, from, count);
+	}
+	if (!combine(to, data, count)) {
+		flush();
+		combine(to, data, count);
+	}
+	return to;
+}
+
+template <size_t S, size_t R> void WriteCombiningLayer<S, R>::flush() {
+	Size offset = 0;
+	for (size_t i = 0; i < _count; i++) {
+		const Range &range = _ranges[i];
+		memory_device().write(range.begin, &_data[offset], range.size);
+		offset += range.size;
+	}
+	_count = 0;
+	_used = 0;
+}
+
+template <size_t S, size_t R>
+Size WriteCombiningLayer<S, R>::offset_of(size_t index) const {
+	Size offset = 0;
+	for (size_t i = 0; i < index; i++) {
+		offset += _ranges[i].size;
+	}
+	return offset;
+}
+
+template <size_t S, size_t R>
+bool WriteCombiningLayer<S, R>::combine(Address to,
+										const uint8_t *from,
+										Size count) {
+	const Address end = to + count;
+
+	// Ranges [first, last) overlap or touch the new write
+	size_t first = 0;
+	while (first < _count && _ranges[first].end() < to) {
+		first++;
+	}
+	size_t last = first;
+	Size merged_bytes = 0;
+	while (last < _count && _ranges[last].begin <= end) {
+		merged_bytes += _ranges[last].size;
+		last++;
+	}
+
+	Address merged_begin = to;
+	Address merged_end = end;
+	if (first < last) {
+		if (_ranges[first].begin < merged_begin) {
+			merged_begin = _ranges[first].begin;
+		}
+		if (_ranges[last - 1].end() > merged_end) {
+			merged_end = _ranges[last - 1].end();
+		}
+	}
+	const Size merged_size = merged_end - merged_begin;
+
+	if (_used - merged_bytes + merged_size > S ||
+		(first == last && _count == R)) {
+		return false;
+	}
+
+	// Make room behind the merged range, it never shrinks
+	const Size offset = offset_of(first);
+	const Size tail = _used - offset - merged_bytes;
+	memmove(&_data[offset + merged_size], &_data[offset + merged_bytes], tail);
+
+	// Spread merged ranges to their positions, back to front to not
+	// overwrite data that has yet to be moved
+	Size source = offset + merged_bytes;
+	for (size_t i = last; i-- > first;) {
+		source -= _ranges[i].size;
+		memmove(&_data[offset + (_ranges[i].begin - merged_begin)],
+				&_data[source],
+				_ranges[i].size);
+	}
+	memcpy(&_data[offset + (to - merged_begin)], from, count);
+
+	// Replace ranges [first, last) with the merged range
+	const size_t removed = last - first;
+	if (removed != 1) {
+		memmove(&_ranges[first + 1],
+				&_ranges[last],
+				(_count - last) * sizeof(Range));
+		_count = _count + 1 - removed;
+	}
+	_ranges[first] = Range{merged_begin, merged_size};
+	_used = _used - merged_bytes + merged_size;
+	return true;
+}
+
+} // namespace layers
+} // namespace rambock
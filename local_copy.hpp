@@ -1,4 +1,6 @@
 #pragma once
+#include "async_memory_device.hpp"
+#include "helpers/pin_table.hpp"
 #include "memory_device.hpp"
 #include <cstddef>
 #include <cstdlib>
@@ -32,12 +34,29 @@ template <typename T> struct LocalCopy {
 	CHECK_CONSTRAINTS(T);
 
 	LocalCopy(MemoryDevice &memory_device, Address address);
+	/** Submits the read and returns immediately
+	 * Blocks on first access until the data has arrived.
+	 */
+	LocalCopy(AsyncMemoryDevice &memory_device, Address address);
+	/** Takes over from another copy, which then aliases this one
+	 * Waits for an outstanding read of the other copy first.
+	 */
+	LocalCopy(LocalCopy &&other);
+	// the pin table refers to the copy, it cannot be duplicated
+	LocalCopy(const LocalCopy &) = delete;
+	LocalCopy &operator=(const LocalCopy &) = delete;
 	~LocalCopy();
 
 	inline MemoryDevice &memory_device() const { return *_memory_device; }
 	inline Address address() const { return _address; }
-	inline T *local_address() const { return _frame.local_address; }
-	inline bool is_first() const { return local_address() == &_frame.value; }
+	inline T *local_address() const {
+		complete();
+		if (_local != &_value) {
+			resolve();
+		}
+		return _local;
+	}
+	inline bool is_first() const { return local_address() == &_value; }
 
 	inline T *operator->() { return local_address(); }
 	inline const T *operator->() const { return local_address(); }
@@ -45,38 +64,108 @@ template <typename T> struct LocalCopy {
 	inline operator T() { return *local_address(); }
 
   private:
-	struct ExternalFrame;
-
 	LocalCopy(MemoryDevice &memory_device, Address address, const T &value);
-	ExternalFrame read_frame() const;
-	void write_frame() const;
+	/** Writes back the bytes of the value that changed since it was read
+	 * Writes the whole value if it was never read from the device.
+	 */
+	void write_back() const;
+	// wait for an outstanding asynchronous read, if any
+	void complete() const;
+	// register as the copy others alias
+	void pin() const;
+	// follow the first copy in case it was moved
+	void resolve() const;
 
 	MemoryDevice *_memory_device;
 	Address _address;
-	ExternalFrame _frame;
+	// the value of the first copy of this object, which may be another one
+	mutable T *_local;
+	mutable T _value;
+	// value as read from the device, to detect modifications
+	mutable T _original;
+	// constructed from a value, the device does not hold the object yet
+	bool _fresh;
+	// whether this copy is registered in the pin table
+	mutable bool _pinned;
+	// device and handle of an outstanding read, nullptr if there is none
+	mutable AsyncMemoryDevice *_pending_device;
+	mutable AsyncMemoryDevice::Request _pending;
 
 	friend struct rambock::helpers::TemplateAllocator;
 	friend struct rambock::external_ptr<T>;
-
-	struct ExternalFrame {
-		T *local_address;
-		T value;
-	};
 };
 
 template <typename T>
 rambock::LocalCopy<T>::LocalCopy(MemoryDevice &memory_device, Address address)
 	: _memory_device{&memory_device}
 	, _address{address}
-	, _frame{read_frame()} {
-	if (_frame.local_address == nullptr) {
-		_frame.local_address = &_frame.value;
+	, _local{static_cast<T *>(
+		  helpers::PinTable::instance().find(memory_device, address))}
+	, _value{}
+	, _original{}
+	, _fresh{false}
+	, _pinned{false}
+	, _pending_device{nullptr}
+	, _pending{0} {
+	if (_local == nullptr) {
+		memory_device.read(&_value, address, sizeof(_value));
+		_original = _value;
+		_local = &_value;
+		pin();
+	}
+}
+
+template <typename T>
+rambock::LocalCopy<T>::LocalCopy(AsyncMemoryDevice &memory_device,
+								 Address address)
+	: _memory_device{&memory_device}
+	, _address{address}
+	, _local{static_cast<T *>(
+		  helpers::PinTable::instance().find(memory_device, address))}
+	, _value{}
+	, _original{}
+	, _fresh{false}
+	, _pinned{false}
+	, _pending_device{nullptr}
+	, _pending{0} {
+	if (_local == nullptr) {
+		// pinned once complete, so no other copy sees the value before
+		_local = &_value;
+		_pending_device = &memory_device;
+		_pending = memory_device.submit_read(
+			&_value, address, sizeof(_value), nullptr, nullptr);
+	}
+}
+
+template <typename T>
+rambock::LocalCopy<T>::LocalCopy(LocalCopy &&other)
+	: _memory_device{other._memory_device}
+	, _address{other._address}
+	, _local{other.local_address()}
+	, _value(other._value)
+	, _original(other._original)
+	, _fresh{other._fresh}
+	, _pinned{false}
+	, _pending_device{nullptr}
+	, _pending{0} {
+	if (_local == &other._value) {
+		_local = &_value;
+		if (other._pinned) {
+			helpers::PinTable::instance().unpin(memory_device(), address());
+			other._pinned = false;
+			pin();
+		}
+		// no longer first, so the other copy neither writes back nor unpins
+		other._local = &_value;
 	}
 }
 
 template <typename T> rambock::LocalCopy<T>::~LocalCopy() {
 	if (is_first()) {
-		write_frame();
+		write_back();
+		if (_pinned) {
+			helpers::PinTable::instance().unpin(memory_device(), address());
+		}
 	}
 }
 
@@ -86,8 +175,14 @@ rambock::LocalCopy<T>::LocalCopy(MemoryDevice &memory_device,
 								 const T &value)
 	: _memory_device{&memory_device}
 	, _address(address)
-	, _frame{nullptr, value} {
-	_frame.local_address = &_frame.value;
+	, _local{&_value}
+	, _value(value)
+	, _original(value)
+	, _fresh{true}
+	, _pinned{false}
+	, _pending_device{nullptr}
+	, _pending{0} {
+	pin();
 }
 
 template <typename T> LocalCopy<T> &LocalCopy<T>::operator=(const T &value) {
@@ -95,16 +190,48 @@ template <typename T> LocalCopy<T> &LocalCopy<T>::operator=(const T &value) {
 	return *this;
 }
 
-template <typename T>
-typename LocalCopy<T>::ExternalFrame LocalCopy<T>::read_frame() const {
-	ExternalFrame frame{};
-	memory_device().read(&frame, address(), sizeof(frame));
-	return frame;
+template <typename T> void LocalCopy<T>::complete() const {
+	if (!_pending_device)
+		return;
+	_pending_device->wait(_pending);
+	_pending_device = nullptr;
+	_original = _value;
+	pin();
+}
+
+template <typename T> void LocalCopy<T>::pin() const {
+	// without room in the table, this copy is not shared
+	_pinned = helpers::PinTable::instance().pin(
+		memory_device(), address(), &_value);
+}
+
+template <typename T> void LocalCopy<T>::resolve() const {
+	T *first = static_cast<T *>(
+		helpers::PinTable::instance().find(memory_device(), address()));
+	if (first) {
+		_local = first;
+	}
 }
 
-template <typename T> void LocalCopy<T>::write_frame() const {
-	ExternalFrame frame{nullptr, _frame.value};
-	memory_device().write(address(), &frame, sizeof(frame));
+template <typename T> void LocalCopy<T>::write_back() const {
+	if (_fresh) {
+		memory_device().write(address(), &_value, sizeof(_value));
+		return;
+	}
+
+	// only write the range of bytes that differ
+	const uint8_t *value = reinterpret_cast<const uint8_t *>(&_value);
+	const uint8_t *original = reinterpret_cast<const uint8_t *>(&_original);
+	Size first = 0, last = sizeof(T);
+	while (first < last && value[first] == original[first]) {
+		first++;
+	}
+	while (last > first && value[last - 1] == original[last - 1]) {
+		last--;
+	}
+	if (first < last) {
+		memory_device().write(address() + first, value + first, last - first);
+	}
 }
 
 } // namespace rambock
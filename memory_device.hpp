@@ -1,9 +1,34 @@
 #pragma once
 
 #include "rambock_common.hpp"
+#include <stddef.h>
+#include <string.h>
+
+// Local buffer used by the default fill, copy and move, in bytes
+#ifndef DEVICE_BUFFER_SIZE
+#define DEVICE_BUFFER_SIZE 32
+#endif
 
 namespace rambock {
 
+/** One range of a vectored read
+ * Mirrors the parameters of MemoryDevice::read
+ */
+struct ReadSegment {
+	void *to;
+	Address from;
+	Size count;
+};
+
+/** One range of a vectored write
+ * Mirrors the parameters of MemoryDevice::write
+ */
+struct WriteSegment {
+	Address to;
+	const void *from;
+	Size count;
+};
+
 /** Abstract Memory Device
  * Allows for multiple layers of caching, paging, etc.
  */
@@ -25,6 +50,97 @@ struct MemoryDevice {
 	 * @return address of written data
 	 */
 	virtual Address write(Address to, const void *from, Size n) = 0;
+
+	/** Reads several ranges from a device into local storage
+	 * Devices may reorder and merge segments to save transactions.
+	 * @param segments the ranges to read, must not overlap in local storage
+	 * @param n the number of segments
+	 */
+	virtual void readv(const ReadSegment *segments, size_t n) {
+		for (size_t i = 0; i < n; i++) {
+			read(segments[i].to, segments[i].from, segments[i].count);
+		}
+	}
+
+	/** Writes several ranges to a device from local storage
+	 * Devices may reorder and merge segments to save transactions.
+	 * @param segments the ranges to write, must not overlap on the device
+	 * @param n the number of segments
+	 */
+	virtual void writev(const WriteSegment *segments, size_t n) {
+		for (size_t i = 0; i < n; i++) {
+			write(segments[i].to, segments[i].from, segments[i].count);
+		}
+	}
+
+	/** Sets a range of a device to a value
+	 * The default writes from a local buffer, devices able to fill without
+	 * transferring every byte should override it.
+	 * @param to the address to fill
+	 * @param value the byte to write
+	 * @param n the number of bytes to fill
+	 */
+	virtual void fill(Address to, uint8_t value, Size n) {
+		uint8_t buffer[DEVICE_BUFFER_SIZE];
+		fill_through(to, value, n, buffer, sizeof(buffer));
+	}
+
+	/** Copies a range within a device
+	 * The default moves the range, devices may override it to take advantage
+	 * of the ranges not overlapping.
+	 * @param to the address to copy the data to
+	 * @param from the address to copy the data from
+	 * @param n the number of bytes to copy, ranges must not overlap
+	 */
+	virtual void copy(Address to, Address from, Size n) { move(to, from, n); }
+
+	/** Copies a range within a device, ranges may overlap
+	 * The default passes the data through a local buffer.
+	 * @param to the address to copy the data to
+	 * @param from the address to copy the data from
+	 * @param n the number of bytes to copy
+	 */
+	virtual void move(Address to, Address from, Size n) {
+		uint8_t buffer[DEVICE_BUFFER_SIZE];
+		move_through(to, from, n, buffer, sizeof(buffer));
+	}
+
+  protected:
+	/** Fills through a local buffer of any size
+	 * For devices preferring fewer, larger writes than the default.
+	 */
+	void fill_through(
+		Address to, uint8_t value, Size n, uint8_t *buffer, Size size) {
+		memset(buffer, value, n < size ? n : size);
+		for (Size done = 0; done < n;) {
+			Size count = n - done < size ? n - done : size;
+			write(to + done, buffer, count);
+			done += count;
+		}
+	}
+
+	/** Moves through a local buffer of any size
+	 * For devices preferring fewer, larger transfers than the default.
+	 */
+	void move_through(
+		Address to, Address from, Size n, uint8_t *buffer, Size size) {
+		if (to < from) {
+			for (Size done = 0; done < n;) {
+				Size count = n - done < size ? n - done : size;
+				read(buffer, from + done, count);
+				write(to + done, buffer, count);
+				done += count;
+			}
+		} else if (from < to) {
+			// backwards, so overlapping bytes are read before being written
+			for (Size left = n; left > 0;) {
+				Size count = left < size ? left : size;
+				left -= count;
+				read(buffer, from + left, count);
+				write(to + left, buffer, count);
+			}
+		}
+	}
 };
 
 } // namespace rambock
@@ -0,0 +1,148 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/** Host stand-in for the Arduino core
+ * Pins and the SPI bus are routed to peripherals attached to an emulated
+ * board, so drivers can be tested without hardware. Add this directory to
+ * the include path to use it in place of the real core.
+ */
+
+#define F_CPU 16000000UL
+
+#define LOW 0
+#define HIGH 1
+
+#define INPUT 0
+#define OUTPUT 1
+
+namespace rambock {
+namespace mocks {
+
+/** Device attached to the emulated board
+ */
+struct Peripheral {
+	virtual ~Peripheral() = default;
+
+	/** Called whenever the board writes a pin
+	 */
+	virtual void pin_changed(int, int) {}
+
+	/** Drives a pin read by the board
+	 * @return true if the peripheral drives the pin
+	 */
+	virtual bool drive(int, int &) { return false; }
+
+	/** Exchanges a byte over the SPI bus, taking 8 clock cycles
+	 * @return the byte shifted out, 0xff if the peripheral is not selected
+	 */
+	virtual uint8_t spi_transfer(uint8_t) { return 0xff; }
+};
+
+/** Pins and peripherals of the emulated board
+ */
+struct Board {
+	static constexpr int PIN_COUNT = 64;
+	static constexpr size_t PERIPHERAL_COUNT = 8;
+
+	/** Connects a peripheral to all pins and the SPI bus
+	 * @return false if too many peripherals are attached
+	 */
+	bool attach(Peripheral &peripheral);
+	void detach(Peripheral &peripheral);
+
+	void pin_mode(int pin, int mode);
+	void write(int pin, int level);
+	int read(int pin) const;
+
+	/** Get the level the board last wrote to a pin
+	 */
+	inline int level(int pin) const { return _levels[pin]; }
+	inline int mode(int pin) const { return _modes[pin]; }
+
+	/** Exchanges a byte with all peripherals
+	 * Unselected peripherals leave MISO high, so results are combined.
+	 */
+	uint8_t spi_transfer(uint8_t out);
+
+	static Board &instance();
+
+  private:
+	Board()
+		: _peripherals{}
+		, _levels{}
+		, _modes{} {}
+
+	Peripheral *_peripherals[PERIPHERAL_COUNT];
+	int _levels[PIN_COUNT];
+	int _modes[PIN_COUNT];
+};
+
+inline bool Board::attach(Peripheral &peripheral) {
+	for (Peripheral *&slot : _peripherals) {
+		if (!slot) {
+			slot = &peripheral;
+			return true;
+		}
+	}
+	return false;
+}
+
+inline void Board::detach(Peripheral &peripheral) {
+	for (Peripheral *&slot : _peripherals) {
+		if (slot == &peripheral) {
+			slot = nullptr;
+		}
+	}
+}
+
+inline void Board::pin_mode(int pin, int mode) { _modes[pin] = mode; }
+
+inline void Board::write(int pin, int level) {
+	_levels[pin] = level;
+	for (Peripheral *peripheral : _peripherals) {
+		if (peripheral) {
+			peripheral->pin_changed(pin, level);
+		}
+	}
+}
+
+inline int Board::read(int pin) const {
+	for (Peripheral *peripheral : _peripherals) {
+		int level = LOW;
+		if (peripheral && peripheral->drive(pin, level)) {
+			return level;
+		}
+	}
+	return _levels[pin];
+}
+
+inline uint8_t Board::spi_transfer(uint8_t out) {
+	uint8_t in = 0xff;
+	for (Peripheral *peripheral : _peripherals) {
+		if (peripheral) {
+			in &= peripheral->spi_transfer(out);
+		}
+	}
+	return in;
+}
+
+inline Board &Board::instance() {
+	static Board board{};
+	return board;
+}
+
+} // namespace mocks
+} // namespace rambock
+
+inline void pinMode(int pin, int mode) {
+	rambock::mocks::Board::instance().pin_mode(pin, mode);
+}
+
+inline void digitalWrite(int pin, int level) {
+	rambock::mocks::Board::instance().write(pin, level);
+}
+
+inline int digitalRead(int pin) {
+	return rambock::mocks::Board::instance().read(pin);
+}
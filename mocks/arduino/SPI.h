@@ -0,0 +1,62 @@
+#pragma once
+#include "Arduino.h"
+
+/** Host stand-in for the Arduino SPI library
+ * Transfers are exchanged with the peripherals of the emulated board.
+ */
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0c
+
+struct SPISettings {
+	SPISettings(uint32_t clock, uint8_t bit_order, uint8_t data_mode)
+		: clock{clock}
+		, bit_order{bit_order}
+		, data_mode{data_mode} {}
+
+	uint32_t clock;
+	uint8_t bit_order;
+	uint8_t data_mode;
+};
+
+struct SPIClass {
+	inline void begin() {}
+	inline void end() {}
+	inline void beginTransaction(SPISettings) {}
+	inline void endTransaction() {}
+
+	inline uint8_t transfer(uint8_t data) {
+		_calls++;
+		return rambock::mocks::Board::instance().spi_transfer(data);
+	}
+
+	/** Exchanges a buffer in place
+	 */
+	inline void transfer(void *buffer, size_t count) {
+		_calls++;
+		uint8_t *bytes = static_cast<uint8_t *>(buffer);
+		for (size_t i = 0; i < count; i++) {
+			bytes[i] = rambock::mocks::Board::instance().spi_transfer(bytes[i]);
+		}
+	}
+
+	/** Get number of calls to transfer, not part of the Arduino API
+	 */
+	inline size_t calls() const { return _calls; }
+	inline void reset_calls() { _calls = 0; }
+
+	static inline SPIClass &instance() {
+		static SPIClass spi{};
+		return spi;
+	}
+
+  private:
+	size_t _calls = 0;
+};
+
+static SPIClass &SPI = SPIClass::instance();
@@ -0,0 +1,317 @@
+#pragma once
+#include "arduino/Arduino.h"
+#include <cstring>
+
+namespace rambock {
+namespace mocks {
+
+/** Emulated Microchip 23LC1024 attached to the emulated board
+ * Decodes commands sent over the SPI bus or, once switched to SQI mode, over
+ * four data pins clocked through digital IO. Counts the clock cycles spent
+ * while selected, so tests can compare how many bus cycles transfers take.
+ * Sequences the real chip would not accept are counted as errors.
+ */
+struct Mock23LC1024 : public Peripheral {
+	static constexpr uint32_t SIZE = 0x20000;
+	static constexpr uint32_t PAGE_SIZE = 32;
+
+	enum Mode : uint8_t {
+		BYTE = 0x00,
+		PAGE = 0x80,
+		SEQUENTIAL = 0x40,
+	};
+
+	/** Constructor for SPI only
+	 * @param cs the chip select pin
+	 */
+	explicit Mock23LC1024(int cs);
+
+	/** Constructor for SPI and SQI
+	 * @param sck the clock pin used in SQI mode
+	 * @param sio0 first of four data pins, sio0 to sio3 form a nibble
+	 */
+	Mock23LC1024(int cs, int sck, int sio0, int sio1, int sio2, int sio3);
+
+	Mock23LC1024(const Mock23LC1024 &) = delete;
+	Mock23LC1024 &operator=(const Mock23LC1024 &) = delete;
+	~Mock23LC1024() override;
+
+	void pin_changed(int pin, int level) override;
+	bool drive(int pin, int &level) override;
+	uint8_t spi_transfer(uint8_t in) override;
+
+	/** Get the contents of the array
+	 */
+	inline uint8_t *memory() { return _memory; }
+
+	inline Mode mode() const { return _mode; }
+	inline bool is_quad() const { return _quad; }
+
+	/** Get number of clock cycles while selected
+	 */
+	inline size_t clocks() const { return _clocks; }
+
+	/** Get number of times the chip was selected
+	 */
+	inline size_t transactions() const { return _transactions; }
+
+	/** Get number of invalid commands and transfers
+	 */
+	inline size_t errors() const { return _errors; }
+
+	void reset_counters();
+
+  private:
+	enum Command : uint8_t {
+		READ = 0x03,
+		WRITE = 0x02,
+		EDIO = 0x3b,
+		EQIO = 0x38,
+		RSTIO = 0xff,
+		RDMR = 0x05,
+		WRMR = 0x01,
+	};
+
+	enum State {
+		COMMAND,
+		ADDRESS,
+		DUMMY,
+		READ_DATA,
+		WRITE_DATA,
+		READ_MODE,
+		WRITE_MODE,
+		// ignore everything until deselected
+		DONE,
+	};
+
+	// byte shifted out next
+	uint8_t output() const;
+	// decode a byte shifted in
+	void input(uint8_t in);
+	// move to the following address according to the mode
+	void advance();
+	// clock a nibble in SQI mode
+	void clock();
+	// nibble on the data pins
+	uint8_t sample() const;
+
+	int _cs, _sck;
+	int _sio[4];
+
+	uint8_t _memory[SIZE];
+	Mode _mode;
+	bool _quad;
+
+	bool _selected;
+	State _state;
+	uint8_t _command;
+	uint32_t _address;
+	size_t _address_bytes;
+
+	// SQI transfers shift two nibbles per byte
+	bool _low_nibble;
+	uint8_t _in, _out;
+	// nibble shifted out in the last clock cycle
+	bool _driving;
+	uint8_t _nibble;
+
+	size_t _clocks, _transactions, _errors;
+};
+
+inline Mock23LC1024::Mock23LC1024(int cs)
+	: Mock23LC1024(cs, -1, -1, -1, -1, -1) {}
+
+inline Mock23LC1024::Mock23LC1024(
+	int cs, int sck, int sio0, int sio1, int sio2, int sio3)
+	: _cs{cs}
+	, _sck{sck}
+	, _sio{sio0, sio1, sio2, sio3}
+	, _memory{}
+	, _mode{SEQUENTIAL}
+	, _quad{false}
+	, _selected{false}
+	, _state{DONE}
+	, _command{0}
+	, _address{0}
+	, _address_bytes{0}
+	, _low_nibble{false}
+	, _in{0}
+	, _out{0}
+	, _driving{false}
+	, _nibble{0}
+	, _clocks{0}
+	, _transactions{0}
+	, _errors{0} {
+	Board::instance().attach(*this);
+}
+
+inline Mock23LC1024::~Mock23LC1024() { Board::instance().detach(*this); }
+
+inline void Mock23LC1024::pin_changed(int pin, int level) {
+	if (pin == _cs) {
+		_selected = level == LOW;
+		if (_selected) {
+			_state = COMMAND;
+			_low_nibble = false;
+			_driving = false;
+			_transactions++;
+		}
+	} else if (pin == _sck && level == HIGH && _selected) {
+		clock();
+	}
+}
+
+inline bool Mock23LC1024::drive(int pin, int &level) {
+	if (!_selected || !_driving) {
+		return false;
+	}
+	for (int i = 0; i < 4; i++) {
+		if (pin == _sio[i]) {
+			level = (_nibble >> i) & 1 ? HIGH : LOW;
+			return true;
+		}
+	}
+	return false;
+}
+
+inline uint8_t Mock23LC1024::spi_transfer(uint8_t in) {
+	if (!_selected) {
+		return 0xff;
+	}
+	_clocks += 8;
+	if (_quad) {
+		// all lines high reads as RSTIO in any mode
+		if (_state == COMMAND && in == RSTIO) {
+			_quad = false;
+			_state = DONE;
+		} else {
+			_errors++;
+		}
+		return 0xff;
+	}
+	const uint8_t out = output();
+	input(in);
+	return out;
+}
+
+inline void Mock23LC1024::reset_counters() {
+	_clocks = _transactions = _errors = 0;
+}
+
+inline uint8_t Mock23LC1024::output() const {
+	switch (_state) {
+	case READ_DATA:
+		return _memory[_address];
+	case READ_MODE:
+		return _mode;
+	default:
+		return 0xff;
+	}
+}
+
+inline void Mock23LC1024::input(uint8_t in) {
+	switch (_state) {
+	case COMMAND:
+		_command = in;
+		switch (in) {
+		case READ:
+		case WRITE:
+			_state = ADDRESS;
+			_address = 0;
+			_address_bytes = 0;
+			break;
+		case RDMR:
+			_state = READ_MODE;
+			break;
+		case WRMR:
+			_state = WRITE_MODE;
+			break;
+		case EQIO:
+			_quad = true;
+			_state = DONE;
+			break;
+		case RSTIO:
+			_quad = false;
+			_state = DONE;
+			break;
+		default:
+			// dual mode is not emulated
+			_errors++;
+			_state = DONE;
+			break;
+		}
+		break;
+	case ADDRESS:
+		_address = (_address << 8 | in) & (SIZE - 1);
+		if (++_address_bytes == 3) {
+			if (_command == WRITE) {
+				_state = WRITE_DATA;
+			} else {
+				// SQI reads wait for a dummy byte
+				_state = _quad ? DUMMY : READ_DATA;
+			}
+		}
+		break;
+	case DUMMY:
+		_state = READ_DATA;
+		break;
+	case READ_DATA:
+		advance();
+		break;
+	case WRITE_DATA:
+		_memory[_address] = in;
+		advance();
+		break;
+	case WRITE_MODE:
+		_mode = Mode(in & 0xc0);
+		_state = DONE;
+		break;
+	case READ_MODE:
+	case DONE:
+		break;
+	}
+}
+
+inline void Mock23LC1024::advance() {
+	switch (_mode) {
+	case BYTE:
+		_state = DONE;
+		break;
+	case PAGE:
+		_address = (_address & ~(PAGE_SIZE - 1)) |
+				   ((_address + 1) & (PAGE_SIZE - 1));
+		break;
+	default:
+		_address = (_address + 1) & (SIZE - 1);
+		break;
+	}
+}
+
+inline void Mock23LC1024::clock() {
+	_clocks++;
+	if (!_quad) {
+		_errors++;
+		return;
+	}
+	if (!_low_nibble) {
+		_driving = _state == READ_DATA || _state == READ_MODE;
+		_out = output();
+		_nibble = _out >> 4;
+		_in = uint8_t(sample() << 4);
+	} else {
+		_nibble = _out & 0x0f;
+		input(uint8_t(_in | sample()));
+	}
+	_low_nibble = !_low_nibble;
+}
+
+inline uint8_t Mock23LC1024::sample() const {
+	uint8_t nibble = 0;
+	for (int i = 0; i < 4; i++) {
+		nibble |= uint8_t(Board::instance().level(_sio[i]) == HIGH) << i;
+	}
+	return nibble;
+}
+
+} // namespace mocks
+} // namespace rambock
@@ -1,6 +1,7 @@
 #pragma once
 #include "../memory_device.hpp"
 #include <cstdlib>
+#include <cstring>
 #include <memory>
 
 namespace rambock {
@@ -21,8 +22,22 @@ template <size_t S> struct MockMemoryDevice : public MemoryDevice {
 		return to;
 	}
 
+	void fill(Address to, uint8_t value, Size count) override {
+		std::memset(to_address(to), value, count);
+	}
+
+	void copy(Address to, Address from, Size count) override {
+		std::memcpy(to_address(to), to_address(from), count);
+	}
+
+	void move(Address to, Address from, Size count) override {
+		std::memmove(to_address(to), to_address(from), count);
+	}
+
   private:
-	inline uint8_t *to_address(Address address) { return &_memory[address]; }
+	inline uint8_t *to_address(Address address) {
+		return &_memory[address.value];
+	}
 	uint8_t _memory[S];
 };
 
@@ -22,6 +22,33 @@ struct MockSlowLayer : public layers::MemoryLayer {
 		return memory_device().write(to, from, n);
 	}
 
+	// A vectored access models a single transaction
+	void readv(const ReadSegment *segments, size_t n) override {
+		wait();
+		memory_device().readv(segments, n);
+	}
+
+	void writev(const WriteSegment *segments, size_t n) override {
+		wait();
+		memory_device().writev(segments, n);
+	}
+
+	// So are accesses done on the device itself
+	void fill(Address to, uint8_t value, Size n) override {
+		wait();
+		memory_device().fill(to, value, n);
+	}
+
+	void copy(Address to, Address from, Size n) override {
+		wait();
+		memory_device().copy(to, from, n);
+	}
+
+	void move(Address to, Address from, Size n) override {
+		wait();
+		memory_device().move(to, from, n);
+	}
+
   private:
 	inline void wait() {
 		std::this_thread::sleep_for(std::chrono::nanoseconds(Nanoseconds));
@@ -1,6 +1,8 @@
 #include "../layers/access_counter.hpp"
 #include "../mocks/mock_memory_device.hpp"
 #include <catch2/catch_all.hpp>
+#include <thread>
+#include <vector>
 
 using namespace rambock;
 using namespace layers;
@@ -41,4 +43,36 @@ TEST_CASE("test access counter", "[layers]") {
 
 		REQUIRE(counter.reads() == 0);
 	}
-}
\ No newline at end of file
+
+	SECTION("vectored accesses count once") {
+		const ReadSegment reads[] = {
+			{&buffer[0], address, 10},
+			{&buffer[10], address + 50, 10},
+		};
+		counter.readv(reads, 2);
+		REQUIRE(counter.reads() == 1);
+
+		const WriteSegment writes[] = {
+			{address, &buffer[0], 10},
+			{address + 50, &buffer[10], 10},
+		};
+		counter.writev(writes, 2);
+		REQUIRE(counter.writes() == 1);
+	}
+
+	SECTION("counts are exact across threads") {
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 4; t++) {
+			threads.emplace_back([&counter, address] {
+				uint8_t local[4];
+				for (int i = 0; i < 1000; i++) {
+					counter.read(local, address, sizeof(local));
+				}
+			});
+		}
+		for (std::thread &thread : threads) {
+			thread.join();
+		}
+		REQUIRE(counter.reads() == 4 * 1000);
+	}
+}
@@ -0,0 +1,129 @@
+#include "../layers/access_profiler.hpp"
+#include "../layers/cache_layer.hpp"
+#include "../mocks/mock_memory_device.hpp"
+#include <catch2/catch_all.hpp>
+#include <string>
+
+using namespace rambock;
+using namespace layers;
+using namespace mocks;
+
+namespace {
+
+// advances by 10 ticks on every call
+uint64_t ticks = 0;
+uint64_t fake_clock() { return ticks += 10; }
+
+// advances by 2^40 ticks on every call
+uint64_t slow_clock() { return ticks += uint64_t(1) << 40; }
+
+void append(const char *line, void *context) {
+	*static_cast<std::string *>(context) += std::string(line) + "\n";
+}
+
+} // namespace
+
+TEST_CASE("access profiler records accesses", "[layers]") {
+	constexpr Size memory_size = 1024;
+	uint8_t buffer[100] = {};
+	Address address = Address(10);
+
+	MockMemoryDevice<memory_size> memory_device{};
+	AccessProfiler profiler{memory_device, &fake_clock};
+
+	SECTION("initial statistics are empty") {
+		REQUIRE(profiler.reads().calls == 0);
+		REQUIRE(profiler.writes().bytes == 0);
+	}
+
+	SECTION("bytes and latencies are recorded") {
+		profiler.read(buffer, address, 100);
+		profiler.read(buffer, address, 3);
+		profiler.write(address, buffer, 64);
+
+		const AccessProfiler::Snapshot snapshot = profiler.snapshot();
+		REQUIRE(snapshot.reads.calls == 2);
+		REQUIRE(snapshot.reads.bytes == 103);
+		REQUIRE(snapshot.reads.time == 20);
+		REQUIRE(snapshot.writes.calls == 1);
+		REQUIRE(snapshot.writes.bytes == 64);
+
+		// 100 lies in [64, 128), 3 in [2, 4) and 10 ticks in [8, 16)
+		REQUIRE(snapshot.reads.sizes.buckets[7] == 1);
+		REQUIRE(snapshot.reads.sizes.buckets[2] == 1);
+		REQUIRE(snapshot.reads.latencies.buckets[4] == 2);
+		REQUIRE(snapshot.writes.sizes.buckets[7] == 1);
+
+		profiler.reset();
+		REQUIRE(profiler.reads().calls == 0);
+		REQUIRE(profiler.reads().sizes.count() == 0);
+		// snapshots are not affected by a reset
+		REQUIRE(snapshot.reads.calls == 2);
+	}
+
+	SECTION("device operations are recorded") {
+		const ReadSegment segments[] = {
+			{&buffer[0], address, 10},
+			{&buffer[10], address + 50, 20},
+		};
+		profiler.readv(segments, 2);
+		profiler.fill(address, 0, 30);
+		profiler.move(address + 1, address, 40);
+
+		REQUIRE(profiler.reads().calls == 2);
+		REQUIRE(profiler.reads().bytes == 70);
+		REQUIRE(profiler.reads().latencies.count() == 1);
+		REQUIRE(profiler.writes().calls == 2);
+		REQUIRE(profiler.writes().bytes == 70);
+	}
+
+	SECTION("statistics are dumped") {
+		profiler.read(buffer, address, 100);
+
+		std::string text;
+		profiler.dump(&append, &text);
+		REQUIRE(text.find("reads: 1 calls, 100 bytes, 10 ticks") !=
+				std::string::npos);
+		REQUIRE(text.find("read size [64, 128): 1") != std::string::npos);
+
+		std::string csv;
+		profiler.dump(&append, &csv, AccessProfiler::CSV);
+		REQUIRE(csv.find("operation,metric,lower,upper,value\n") == 0);
+		REQUIRE(csv.find("read,bytes,,,100\n") != std::string::npos);
+		REQUIRE(csv.find("read,latency,8,16,1\n") != std::string::npos);
+		REQUIRE(csv.find("write,calls,,,0\n") != std::string::npos);
+	}
+
+	SECTION("the last bucket is open-ended") {
+		AccessProfiler slow{memory_device, &slow_clock};
+		slow.read(buffer, address, 1);
+		REQUIRE(slow.reads().latencies.buckets[31] == 1);
+		REQUIRE(AccessProfiler::Histogram::upper_bound(31) == UINT64_MAX);
+
+		std::string text;
+		slow.dump(&append, &text);
+		REQUIRE(text.find("read latency [1073741824, inf): 1") !=
+				std::string::npos);
+
+		std::string csv;
+		slow.dump(&append, &csv, AccessProfiler::CSV);
+		REQUIRE(csv.find("read,latency,1073741824,,1\n") != std::string::npos);
+	}
+
+	SECTION("profilers show what a cache saves") {
+		CacheLayer<64> cache{profiler};
+		AccessProfiler cached{cache, &fake_clock};
+
+		for (Size i = 0; i < 16; i++) {
+			int value = int(i);
+			cached.write(address + i * sizeof(int), &value, sizeof(value));
+		}
+		cache.flush();
+
+		REQUIRE(cached.writes().calls == 16);
+		REQUIRE(cached.writes().bytes == 16 * sizeof(int));
+		// the cache passes the writes on in a few larger transfers
+		REQUIRE(profiler.writes().calls < 4);
+		REQUIRE(profiler.writes().bytes == 16 * sizeof(int));
+	}
+}
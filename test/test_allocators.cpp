@@ -0,0 +1,85 @@
+#include "../allocators/buddy_allocator.hpp"
+#include "../allocators/compacting_allocator.hpp"
+#include "../allocators/segregated_allocator.hpp"
+#include "../allocators/simple_allocator.hpp"
+#include "../mocks/mock_memory_device.hpp"
+#include <catch2/catch_all.hpp>
+#include <cstring>
+
+using namespace rambock;
+using namespace allocators;
+using namespace mocks;
+
+// The contract every allocator fulfils, specifics are tested per allocator
+TEMPLATE_TEST_CASE("Allocators allocate memory",
+				   "[allocators]",
+				   SimpleAllocator,
+				   SegregatedAllocator<>,
+				   BuddyAllocator<>,
+				   CompactingAllocator<>) {
+	constexpr Size memory_size = 1024;
+	MockMemoryDevice<memory_size> memory_device{};
+	TestType allocator{memory_device, Address(memory_size)};
+
+	SECTION("Allocation returns an address") {
+		Address address = allocator.allocate(100);
+		REQUIRE(address);
+	}
+
+	SECTION("Allocations do not overlap") {
+		Address a = allocator.allocate(100);
+		Address b = allocator.allocate(100);
+		REQUIRE(a);
+		REQUIRE(b);
+
+		// addresses are resolved by the allocator's device, which may differ
+		// from the physical one
+		MemoryDevice &device = allocator.memory_device();
+		uint8_t ones[100], twos[100], data[100];
+		memset(ones, 1, sizeof(ones));
+		memset(twos, 2, sizeof(twos));
+		device.write(a, ones, sizeof(ones));
+		device.write(b, twos, sizeof(twos));
+		device.read(data, a, sizeof(data));
+		REQUIRE(memcmp(data, ones, sizeof(data)) == 0);
+	}
+
+	SECTION("Freed memory is reused") {
+		Address last = allocator.allocate(100);
+		while (Address next = allocator.allocate(100)) {
+			last = next;
+		}
+		REQUIRE(allocator.free(last) > 0);
+		REQUIRE(allocator.allocate(100));
+	}
+
+	SECTION("Allocations count against free bytes") {
+		Size free_bytes = allocator.get_free_bytes();
+		allocator.allocate(100);
+		REQUIRE(allocator.get_free_bytes() < free_bytes);
+	}
+
+	SECTION("Frees count towards free bytes") {
+		Address address = allocator.allocate(100);
+		Size before = allocator.get_free_bytes();
+		allocator.free(address);
+		Size after = allocator.get_free_bytes();
+		REQUIRE(before < after);
+	}
+
+	SECTION("Full free reclaims full memory") {
+		Size before = allocator.get_free_bytes();
+		Address address = allocator.allocate(100);
+		allocator.free(address);
+		Size after = allocator.get_free_bytes();
+
+		REQUIRE(before == after);
+	}
+
+	SECTION("Too large allocations fail") {
+		Size before = allocator.get_free_bytes();
+		Address address = allocator.allocate(memory_size * 2);
+		REQUIRE(!address);
+		REQUIRE(allocator.get_free_bytes() == before);
+	}
+}
@@ -0,0 +1,127 @@
+#include "../allocators/bump_allocator.hpp"
+#include "../async_memory_device.hpp"
+#include "../helpers/template_allocator.hpp"
+#include "../helpers/threaded_device.hpp"
+#include "../layers/cache_layer.hpp"
+#include "../mocks/mock_memory_device.hpp"
+#include "../mocks/mock_slow_layer.hpp"
+#include <catch2/catch_all.hpp>
+
+using namespace rambock;
+using namespace allocators;
+using namespace helpers;
+using namespace layers;
+using namespace mocks;
+
+TEST_CASE("threaded device completes requests", "[async]") {
+	constexpr Size memory_size = 1024;
+	Address address = Address{16};
+
+	MockMemoryDevice<memory_size> mock_memory_device{};
+	MockSlowLayer<1000> slow_layer{mock_memory_device};
+	ThreadedDevice threaded_device{slow_layer};
+
+	SECTION("submitted requests complete in order") {
+		int values[] = {1, 2, 3};
+		AsyncMemoryDevice::Request requests[3];
+		for (Size i = 0; i < 3; i++) {
+			requests[i] =
+				threaded_device.submit_write(address + i * sizeof(int),
+											 &values[i],
+											 sizeof(int),
+											 nullptr,
+											 nullptr);
+		}
+		threaded_device.wait(requests[2]);
+		REQUIRE(threaded_device.poll(requests[0]));
+		REQUIRE(threaded_device.poll(requests[1]));
+
+		int readback[3] = {};
+		auto request = threaded_device.submit_read(
+			&readback, address, sizeof(readback), nullptr, nullptr);
+		threaded_device.wait(request);
+		REQUIRE(memcmp(readback, values, sizeof(values)) == 0);
+	}
+
+	SECTION("callbacks signal completion") {
+		int value = 10;
+		bool called = false;
+		auto request = threaded_device.submit_write(
+			address,
+			&value,
+			sizeof(value),
+			[](void *context) { *static_cast<bool *>(context) = true; },
+			&called);
+		threaded_device.wait(request);
+		REQUIRE(called);
+	}
+
+	SECTION("synchronous accesses wait for completion") {
+		int value = 20;
+		threaded_device.write(address, &value, sizeof(value));
+		int readback = 0;
+		threaded_device.read(&readback, address, sizeof(readback));
+		REQUIRE(readback == value);
+	}
+
+	SECTION("local copies fetch early") {
+		BumpAllocator bump_allocator{threaded_device, Address{memory_size}};
+		TemplateAllocator allocator{bump_allocator};
+		auto ptr = allocator.make_external<int>(30);
+
+		auto copy = ptr.prefetch(threaded_device);
+		int value = copy;
+		REQUIRE(value == 30);
+		REQUIRE(copy.is_first());
+	}
+
+	SECTION("local copies prefetch through the allocator's layers") {
+		CacheLayer<64> cache_layer{threaded_device};
+		BumpAllocator bump_allocator{cache_layer, Address{memory_size}};
+		TemplateAllocator allocator{bump_allocator};
+		auto ptr = allocator.make_external<int>(1);
+		// only held by the cache
+		*ptr = 2;
+
+		{
+			auto copy = ptr.prefetch(threaded_device);
+			auto alias = *ptr;
+			REQUIRE(int(copy) == 2);
+			REQUIRE(!alias.is_first());
+			copy = 3;
+		}
+		cache_layer.flush();
+		int value = 0;
+		mock_memory_device.read(&value, ptr.address(), sizeof(value));
+		REQUIRE(value == 3);
+	}
+
+	SECTION("cache prefetches overlap with computation") {
+		int value = 50;
+		mock_memory_device.write(address, &value, sizeof(value));
+
+		CacheLayer<64> cache_layer{threaded_device};
+		cache_layer.prefetch(address);
+		REQUIRE(cache_layer.is_cached(address, sizeof(value)));
+
+		int readback = 0;
+		cache_layer.read(&readback, address, sizeof(readback));
+		REQUIRE(readback == value);
+	}
+}
+
+TEST_CASE("blocking async device completes immediately", "[async]") {
+	constexpr Size memory_size = 1024;
+	MockMemoryDevice<memory_size> mock_memory_device{};
+	BlockingAsyncDevice async_device{mock_memory_device};
+
+	int value = 60;
+	auto request = async_device.submit_write(
+		Address{8}, &value, sizeof(value), nullptr, nullptr);
+	REQUIRE(request != 0);
+	REQUIRE(async_device.poll(request));
+
+	int readback = 0;
+	async_device.read(&readback, Address{8}, sizeof(readback));
+	REQUIRE(readback == value);
+}
@@ -0,0 +1,109 @@
+#include "../allocators/buddy_allocator.hpp"
+#include "../helpers/template_allocator.hpp"
+#include "../mocks/mock_memory_device.hpp"
+#include <catch2/catch_all.hpp>
+
+using namespace rambock;
+using namespace allocators;
+using namespace helpers;
+using namespace mocks;
+
+TEST_CASE("Buddy allocator splits and merges blocks", "[buddy_allocator]") {
+	constexpr Size memory_size = 4096 + 32;
+	// leave room for a remainder after the largest block
+	MockMemoryDevice<memory_size + 48> memory_device{};
+	BuddyAllocator<9> allocator{memory_device, Address(memory_size)};
+	const Size free_bytes = allocator.get_free_bytes();
+
+	SECTION("Blocks are powers of two") {
+		Address address = allocator.allocate(60);
+		REQUIRE(allocator.get_free_bytes() == free_bytes - 64);
+		REQUIRE(allocator.free(address) == 64 - sizeof(Size));
+	}
+
+	SECTION("Buddies are adjacent") {
+		Address a = allocator.allocate(12);
+		Address b = allocator.allocate(12);
+		REQUIRE(b == a + 16);
+	}
+
+	SECTION("Freed buddies are merged") {
+		Address addresses[256];
+		for (Address &address : addresses) {
+			address = allocator.allocate(12);
+			REQUIRE(address);
+		}
+		REQUIRE(!allocator.allocate(12));
+
+		// free in an order that merges late
+		for (int i = 0; i < 256; i += 2) {
+			allocator.free(addresses[i]);
+		}
+		REQUIRE(!allocator.allocate(100));
+		for (int i = 1; i < 256; i += 2) {
+			allocator.free(addresses[i]);
+		}
+		REQUIRE(allocator.get_free_bytes() == free_bytes);
+
+		// all memory is one block again
+		REQUIRE(allocator.allocate(4096 - sizeof(Size)));
+	}
+
+	SECTION("Double free is ignored") {
+		Address a = allocator.allocate(12);
+		allocator.allocate(12);
+		REQUIRE(allocator.free(a) > 0);
+		REQUIRE(allocator.free(a) == 0);
+		REQUIRE(allocator.get_free_bytes() == free_bytes - 16);
+	}
+
+	SECTION("Double free of a merged upper buddy is ignored") {
+		Address lower = allocator.allocate(12);
+		Address upper = allocator.allocate(12);
+		REQUIRE(upper == lower + 16);
+		REQUIRE(allocator.free(lower) > 0);
+		REQUIRE(allocator.free(upper) > 0);
+		REQUIRE(allocator.free(upper) == 0);
+		REQUIRE(allocator.get_free_bytes() == free_bytes);
+
+		// both blocks are handed out once
+		Address a = allocator.allocate(12);
+		Address b = allocator.allocate(12);
+		REQUIRE(a);
+		REQUIRE(b);
+		REQUIRE(a != b);
+		REQUIRE(allocator.get_free_bytes() == free_bytes - 32);
+	}
+
+	SECTION("Remainders without buddies are used") {
+		BuddyAllocator<9> uneven{memory_device, Address(memory_size + 48)};
+		REQUIRE(uneven.get_free_bytes() == free_bytes + 48);
+		REQUIRE(uneven.allocate(4096 - sizeof(Size)));
+		REQUIRE(uneven.allocate(28));
+		REQUIRE(uneven.allocate(12));
+		REQUIRE(!uneven.allocate(1));
+	}
+}
+
+TEST_CASE("Buddy allocator works with external pointers",
+		  "[buddy_allocator]") {
+	constexpr Size memory_size = 1024;
+	MockMemoryDevice<memory_size> memory_device{};
+	BuddyAllocator<> buddy_allocator{memory_device, Address(memory_size)};
+	TemplateAllocator allocator{buddy_allocator};
+
+	const Size free_bytes = buddy_allocator.get_free_bytes();
+	auto a = allocator.make_external<int>(1);
+	auto b = allocator.make_external<int>(2);
+	REQUIRE(a.address());
+	REQUIRE(b.address());
+	*a = 3;
+	int value = *a;
+	REQUIRE(value == 3);
+	value = *b;
+	REQUIRE(value == 2);
+
+	a.free();
+	b.free();
+	REQUIRE(buddy_allocator.get_free_bytes() == free_bytes);
+}
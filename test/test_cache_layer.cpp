@@ -117,4 +117,103 @@ TEST_CASE("cache layer caches accesses", "[layers]") {
 		cache_layer.refresh();
 		REQUIRE(!cache_layer.dirty());
 	}
+
+	SECTION("flush only writes back modified bytes") {
+		uint8_t window[cache_size] = {};
+		cache_layer.read(&window, low_address, sizeof(window));
+
+		int value = 42;
+		cache_layer.write(low_address + 8, &value, sizeof(value));
+
+		// Change the device behind the cache to detect unwanted write-backs
+		uint8_t marker = 0xaa;
+		mock_memory_device.write(low_address, &marker, sizeof(marker));
+
+		int writes_before_flush = access_counter.writes();
+		cache_layer.flush();
+		REQUIRE(access_counter.writes() == writes_before_flush + 1);
+
+		uint8_t readback = 0;
+		mock_memory_device.read(&readback, low_address, sizeof(readback));
+		REQUIRE(readback == marker);
+		int value_readback = 0;
+		mock_memory_device.read(
+			&value_readback, low_address + 8, sizeof(value_readback));
+		REQUIRE(value_readback == value);
+	}
+
+	SECTION("adjacent modifications are flushed together") {
+		int values[4] = {1, 2, 3, 4};
+		for (Size i = 0; i < 4; i++) {
+			cache_layer.write(
+				low_address + i * sizeof(int), &values[i], sizeof(int));
+		}
+		int far_value = 5;
+		cache_layer.write(low_address + 48, &far_value, sizeof(far_value));
+
+		int writes_before_flush = access_counter.writes();
+		cache_layer.flush();
+		REQUIRE(access_counter.writes() == writes_before_flush + 2);
+	}
+
+	SECTION("vectored accesses serve cached segments") {
+		int values[] = {1, 2, 3};
+		cache_layer.write(low_address, &values[0], sizeof(int));
+		mock_memory_device.write(high_address, &values[1], sizeof(int));
+		mock_memory_device.write(high_address + 8, &values[2], sizeof(int));
+
+		int readback[3] = {};
+		const ReadSegment reads[] = {
+			{&readback[0], low_address, sizeof(int)},
+			{&readback[1], high_address, sizeof(int)},
+			{&readback[2], high_address + 8, sizeof(int)},
+		};
+		int reads_before = access_counter.reads();
+		cache_layer.readv(reads, 3);
+
+		// Both uncached segments are forwarded together
+		REQUIRE(access_counter.reads() == reads_before + 1);
+		REQUIRE(memcmp(readback, values, sizeof(values)) == 0);
+		REQUIRE(cache_layer.is_cached(low_address, sizeof(int)));
+
+		int new_values[] = {4, 5};
+		const WriteSegment writes[] = {
+			{low_address, &new_values[0], sizeof(int)},
+			{high_address, &new_values[1], sizeof(int)},
+		};
+		cache_layer.writev(writes, 2);
+		cache_layer.read(&readback[0], low_address, sizeof(int));
+		mock_memory_device.read(&readback[1], high_address, sizeof(int));
+		REQUIRE(readback[0] == new_values[0]);
+		REQUIRE(readback[1] == new_values[1]);
+	}
+
+	SECTION("fills and moves stay in the cache") {
+		cache_layer.read(&data, low_address, sizeof(data));
+		int reads_before = access_counter.reads();
+		int writes_before = access_counter.writes();
+
+		cache_layer.fill(low_address, 0x11, sizeof(Data));
+		cache_layer.move(low_address + 4, low_address, sizeof(Data));
+		REQUIRE(access_counter.reads() == reads_before);
+		REQUIRE(access_counter.writes() == writes_before);
+
+		uint8_t readback[sizeof(Data) + 4];
+		cache_layer.read(readback, low_address, sizeof(readback));
+		for (uint8_t byte : readback) {
+			REQUIRE(byte == 0x11);
+		}
+	}
+
+	SECTION("fills reach past the cache") {
+		cache_layer.read(&data, low_address, sizeof(data));
+		cache_layer.fill(low_address, 0x22, 2 * cache_size);
+		cache_layer.flush();
+
+		uint8_t readback[2 * cache_size];
+		mock_memory_device.read(readback, low_address, sizeof(readback));
+		for (uint8_t byte : readback) {
+			REQUIRE(byte == 0x22);
+		}
+	}
 }
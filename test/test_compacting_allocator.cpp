@@ -0,0 +1,103 @@
+#include "../allocators/compacting_allocator.hpp"
+#include "../helpers/template_allocator.hpp"
+#include "../layers/access_counter.hpp"
+#include "../mocks/mock_memory_device.hpp"
+#include <catch2/catch_all.hpp>
+
+using namespace rambock;
+using namespace allocators;
+using namespace helpers;
+using namespace layers;
+using namespace mocks;
+
+TEST_CASE("Compacting allocator runs out of handles",
+		  "[compacting_allocator]") {
+	constexpr Size memory_size = 1024;
+	MockMemoryDevice<memory_size> memory_device{};
+	CompactingAllocator<2> allocator{memory_device, Address(memory_size)};
+	REQUIRE(allocator.allocate(4));
+	REQUIRE(allocator.allocate(4));
+	REQUIRE(!allocator.allocate(4));
+}
+
+TEST_CASE("Compacting allocator closes gaps", "[compacting_allocator]") {
+	constexpr Size memory_size = 32 + 1024;
+	MockMemoryDevice<memory_size> memory_device{};
+	AccessCounter access_counter{memory_device};
+	CompactingAllocator<32, 16, 16> allocator{access_counter,
+											  Address(memory_size)};
+	TemplateAllocator template_allocator{allocator};
+
+	// fill memory with pointers to ints and fillers, 64 bytes per pair
+	const Size pointer_block = 8 + external_ptr<int>::allocation_size;
+	external_ptr<int> pointers[16];
+	Address fillers[16];
+	for (int i = 0; i < 16; i++) {
+		pointers[i] = template_allocator.make_external<int>(i);
+		fillers[i] = allocator.allocate(64 - pointer_block - 8);
+	}
+	REQUIRE(allocator.get_free_bytes() == 0);
+	for (Address filler : fillers) {
+		allocator.free(filler);
+	}
+	const Size free_bytes = allocator.get_free_bytes();
+
+	auto check_values = [&](int from) {
+		for (int i = from; i < 16; i++) {
+			int value = *pointers[i];
+			REQUIRE(value == i);
+		}
+	};
+
+	SECTION("Large allocations succeed after compaction") {
+		REQUIRE(!allocator.allocate(256));
+		REQUIRE(allocator.compact());
+		REQUIRE(!allocator.is_compacting());
+		REQUIRE(allocator.get_free_bytes() == free_bytes);
+		REQUIRE(allocator.allocate(free_bytes - 8));
+		check_values(0);
+	}
+
+	SECTION("Compaction is incremental") {
+		int calls = 0;
+		access_counter.reset();
+		while (!allocator.compact(32)) {
+			calls++;
+			// a few headers and chunks at most
+			REQUIRE(access_counter.reads() + access_counter.writes() <= 8);
+
+			// blocks are accessible while they are moved
+			check_values(0);
+			access_counter.reset();
+		}
+		REQUIRE(calls > 8);
+		REQUIRE(allocator.allocate(free_bytes - 8));
+	}
+
+	SECTION("Writes during compaction are kept") {
+		allocator.compact(40);
+		REQUIRE(allocator.is_compacting());
+		for (int i = 0; i < 16; i++) {
+			*pointers[i] = 100 + i;
+		}
+		REQUIRE(allocator.compact());
+		for (int i = 0; i < 16; i++) {
+			int value = *pointers[i];
+			REQUIRE(value == 100 + i);
+		}
+	}
+
+	SECTION("Blocks can be freed while they are moved") {
+		for (int i = 0; i < 8; i++) {
+			allocator.compact(8);
+			pointers[i].free();
+		}
+		REQUIRE(allocator.compact());
+		// blocks freed behind the pass leave gaps for the next one
+		REQUIRE(allocator.compact());
+		check_values(8);
+		const Size freed = 8 * pointer_block;
+		REQUIRE(allocator.get_free_bytes() == free_bytes + freed);
+		REQUIRE(allocator.allocate(free_bytes + freed - 8));
+	}
+}
@@ -0,0 +1,117 @@
+#include "../allocators/bump_allocator.hpp"
+#include "../allocators/segregated_allocator.hpp"
+#include "../layers/access_counter.hpp"
+#include "../layers/compression_layer.hpp"
+#include "../mocks/mock_memory_device.hpp"
+#include <catch2/catch_all.hpp>
+
+using namespace rambock;
+using namespace allocators;
+using namespace layers;
+using namespace mocks;
+
+TEST_CASE("compression layer stores pages compressed", "[layers]") {
+	constexpr Size memory_size = 8 * 1024;
+	constexpr Size page_size = 128;
+	constexpr size_t page_count = 64;
+	using Layer = CompressionLayer<page_size, page_count>;
+
+	MockMemoryDevice<memory_size> mock_memory_device{};
+	AccessCounter access_counter{mock_memory_device};
+	SegregatedAllocator<> storage{access_counter, Address(memory_size)};
+	Layer layer{storage};
+
+	uint8_t data[3 * page_size];
+	uint8_t readback[sizeof(data)] = {};
+
+	SECTION("data survives eviction") {
+		for (size_t i = 0; i < sizeof(data); i++) {
+			data[i] = uint8_t(i * 31 + i / 7);
+		}
+		Address address = Address(page_size / 2);
+		REQUIRE(layer.write(address, data, sizeof(data)) == address);
+		// touch other pages so the written ones are evicted
+		for (Size page = 10; page < 14; page++) {
+			layer.read(readback, Address(page * page_size), 1);
+		}
+		REQUIRE(layer.read(readback, address, sizeof(readback)));
+		REQUIRE(memcmp(readback, data, sizeof(data)) == 0);
+	}
+
+	SECTION("zero pages are not stored") {
+		memset(data, 0, sizeof(data));
+		layer.write(Address(0), data, sizeof(data));
+		REQUIRE(layer.flush());
+		REQUIRE(layer.stored_bytes() == 0);
+		REQUIRE(layer.page_count(Layer::ZERO) == page_count);
+		REQUIRE(access_counter.writes() == 0);
+	}
+
+	SECTION("runs are encoded") {
+		memset(data, 7, page_size);
+		memset(data + page_size / 2, 9, page_size / 2);
+		layer.write(Address(0), data, page_size);
+		REQUIRE(layer.flush());
+		REQUIRE(layer.page_count(Layer::RLE) == 1);
+		REQUIRE(layer.stored_bytes() < page_size / 8);
+		REQUIRE(layer.compression_ratio() > 8);
+	}
+
+	SECTION("incompressible pages are stored raw") {
+		for (size_t i = 0; i < page_size; i++) {
+			data[i] = uint8_t(i);
+		}
+		layer.write(Address(0), data, page_size);
+		REQUIRE(layer.flush());
+		REQUIRE(layer.page_count(Layer::RAW) == 1);
+		REQUIRE(layer.stored_bytes() == page_size);
+	}
+
+	SECTION("blocks are released once pages are cleared") {
+		for (size_t i = 0; i < page_size; i++) {
+			data[i] = uint8_t(i);
+		}
+		layer.write(Address(0), data, page_size);
+		REQUIRE(layer.flush());
+		const Size free_bytes = storage.get_free_bytes();
+
+		memset(data, 0, page_size);
+		layer.write(Address(0), data, page_size);
+		REQUIRE(layer.flush());
+		REQUIRE(layer.stored_bytes() == 0);
+		REQUIRE(storage.get_free_bytes() > free_bytes);
+	}
+
+	SECTION("cached pages do not access the device") {
+		layer.read(readback, Address(0), page_size);
+		access_counter.reset();
+		layer.write(Address(4), data, 8);
+		layer.read(readback, Address(0), page_size);
+		REQUIRE(access_counter.reads() == 0);
+		REQUIRE(access_counter.writes() == 0);
+	}
+
+	SECTION("out of bounds accesses fail") {
+		REQUIRE(!layer.read(readback, Address(Layer::size()), 1));
+		REQUIRE(!layer.write(Address(Layer::size() - 1), data, 2));
+	}
+}
+
+TEST_CASE("compression layer fails if storage runs out", "[layers]") {
+	constexpr Size memory_size = 512;
+	constexpr Size page_size = 128;
+
+	MockMemoryDevice<memory_size> mock_memory_device{};
+	BumpAllocator storage{mock_memory_device, Address(memory_size)};
+	CompressionLayer<page_size, 16, 1> layer{storage};
+
+	uint8_t data[page_size];
+	for (size_t i = 0; i < page_size; i++) {
+		data[i] = uint8_t(i);
+	}
+	bool failed = false;
+	for (Size page = 0; page < 16 && !failed; page++) {
+		failed = !layer.write(Address(page * page_size), data, page_size);
+	}
+	REQUIRE(failed);
+}
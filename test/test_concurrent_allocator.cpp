@@ -0,0 +1,96 @@
+#include "../allocators/concurrent_allocator.hpp"
+#include "../allocators/segregated_allocator.hpp"
+#include "../layers/access_counter.hpp"
+#include "../layers/sharded_cache_layer.hpp"
+#include "../mocks/mock_memory_device.hpp"
+#include <catch2/catch_all.hpp>
+#include <thread>
+#include <vector>
+
+using namespace rambock;
+using namespace allocators;
+using namespace layers;
+using namespace mocks;
+
+TEST_CASE("Concurrent allocator caches blocks", "[concurrent_allocator]") {
+	constexpr Size memory_size = 64 * 1024;
+	static MockMemoryDevice<memory_size> memory_device{};
+	AccessCounter counter{memory_device};
+	SegregatedAllocator<12> backend{counter, Address(memory_size)};
+	ConcurrentAllocator<> allocator{backend};
+
+	SECTION("Allocations do not overlap") {
+		Address a = allocator.allocate(100);
+		Address b = allocator.allocate(100);
+		REQUIRE(a);
+		REQUIRE(b);
+		REQUIRE((a + 100 <= b || b + 100 <= a));
+	}
+
+	SECTION("Freed blocks are reused without the device") {
+		Address a = allocator.allocate(100);
+		const Size backend_free = backend.get_free_bytes();
+		REQUIRE(allocator.free(a) >= 100);
+
+		counter.reset();
+		Address b = allocator.allocate(100);
+		REQUIRE(a == b);
+		REQUIRE(counter.reads() == 0);
+		REQUIRE(counter.writes() == 0);
+		REQUIRE(backend.get_free_bytes() == backend_free);
+	}
+
+	SECTION("Large blocks bypass the caches") {
+		const Size free_bytes = allocator.get_free_bytes();
+		Address a = allocator.allocate(8 * 1024);
+		REQUIRE(a);
+		REQUIRE(allocator.get_free_bytes() < free_bytes);
+		REQUIRE(allocator.free(a) >= 8 * 1024);
+	}
+
+	SECTION("Cached blocks count as free") {
+		const Size free_bytes = allocator.get_free_bytes();
+		Address a = allocator.allocate(10);
+		REQUIRE(allocator.get_free_bytes() < free_bytes);
+		allocator.free(a);
+		REQUIRE(allocator.get_free_bytes() == free_bytes);
+	}
+
+	SECTION("Threads allocate concurrently") {
+		constexpr size_t thread_count = 4;
+		constexpr size_t block_count = 64;
+		ShardedCacheLayer<32, 8> cache{memory_device};
+		SegregatedAllocator<12> shared_backend{cache, Address(memory_size)};
+		ConcurrentAllocator<> shared{shared_backend};
+		const Size free_bytes = shared.get_free_bytes();
+
+		std::vector<std::thread> threads;
+		bool failed[thread_count] = {};
+		for (size_t t = 0; t < thread_count; t++) {
+			threads.emplace_back([&, t] {
+				Address blocks[block_count];
+				for (int round = 0; round < 10; round++) {
+					for (size_t i = 0; i < block_count; i++) {
+						blocks[i] = shared.allocate(Size(4 + i % 60));
+						const int value = int(t * 1000 + i);
+						cache.write(blocks[i], &value, sizeof(value));
+					}
+					for (size_t i = 0; i < block_count; i++) {
+						int value = 0;
+						cache.read(&value, blocks[i], sizeof(value));
+						failed[t] |= value != int(t * 1000 + i);
+						shared.free(blocks[i]);
+					}
+				}
+			});
+		}
+		for (std::thread &thread : threads) {
+			thread.join();
+		}
+
+		for (bool thread_failed : failed) {
+			REQUIRE(!thread_failed);
+		}
+		REQUIRE(shared.get_free_bytes() == free_bytes);
+	}
+}
@@ -1,7 +1,10 @@
+#include "../memory_device.hpp"
+#include "../mocks/mock_memory_device.hpp"
 #include "../rambock_common.hpp"
 #include <catch2/catch_all.hpp>
 
 using namespace rambock;
+using namespace mocks;
 
 TEST_CASE("test address semantics", "[core]") {
 	Address a = Address::null();
@@ -21,4 +24,59 @@ TEST_CASE("test address semantics", "[core]") {
 		d += 1;
 		REQUIRE(d == b);
 	}
-}
\ No newline at end of file
+}
+
+TEST_CASE("default fill, copy and move go through read and write", "[core]") {
+	constexpr Size memory_size = 256;
+	constexpr Size count = 3 * DEVICE_BUFFER_SIZE + 5;
+
+	// only implements read and write, so the defaults are used
+	struct PlainDevice : MemoryDevice {
+		MemoryDevice &inner;
+		explicit PlainDevice(MemoryDevice &inner) : inner{inner} {}
+		void *read(void *to, Address from, Size n) override {
+			return inner.read(to, from, n);
+		}
+		Address write(Address to, const void *from, Size n) override {
+			return inner.write(to, from, n);
+		}
+	};
+
+	MockMemoryDevice<memory_size> mock_memory_device{};
+	PlainDevice device{mock_memory_device};
+
+	uint8_t expected[memory_size];
+	for (Size i = 0; i < memory_size; i++) {
+		expected[i] = uint8_t(i);
+	}
+	mock_memory_device.write(Address(0), expected, memory_size);
+	uint8_t readback[memory_size];
+
+	SECTION("fill sets every byte") {
+		device.fill(Address(10), 0xab, count);
+		memset(expected + 10, 0xab, count);
+		mock_memory_device.read(readback, Address(0), memory_size);
+		REQUIRE(memcmp(readback, expected, memory_size) == 0);
+	}
+
+	SECTION("copy duplicates a range") {
+		device.copy(Address(150), Address(0), count);
+		memcpy(expected + 150, expected, count);
+		mock_memory_device.read(readback, Address(0), memory_size);
+		REQUIRE(memcmp(readback, expected, memory_size) == 0);
+	}
+
+	SECTION("overlapping moves towards higher addresses") {
+		device.move(Address(20), Address(10), count);
+		memmove(expected + 20, expected + 10, count);
+		mock_memory_device.read(readback, Address(0), memory_size);
+		REQUIRE(memcmp(readback, expected, memory_size) == 0);
+	}
+
+	SECTION("overlapping moves towards lower addresses") {
+		device.move(Address(10), Address(20), count);
+		memmove(expected + 10, expected + 20, count);
+		mock_memory_device.read(readback, Address(0), memory_size);
+		REQUIRE(memcmp(readback, expected, memory_size) == 0);
+	}
+}
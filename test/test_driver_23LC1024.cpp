@@ -0,0 +1,155 @@
+#include "../drivers/driver_23LC1024.hpp"
+#include "../mocks/mock_23LC1024.hpp"
+#include <catch2/catch_all.hpp>
+
+using namespace rambock;
+using namespace mocks;
+
+TEST_CASE("23LC1024 driver transfers in bursts", "[drivers]") {
+	constexpr int cs = 10;
+	constexpr Size count = 100;
+	Address address = Address(0x1234);
+
+	Mock23LC1024 chip{cs};
+	Driver_23LC1024 driver{cs};
+	driver.begin();
+	chip.reset_counters();
+	SPI.reset_calls();
+
+	uint8_t data[count];
+	for (Size i = 0; i < count; i++) {
+		data[i] = uint8_t(i * 7);
+	}
+
+	SECTION("data reaches the chip") {
+		driver.write(address, data, count);
+		REQUIRE(memcmp(chip.memory() + address.value, data, count) == 0);
+
+		uint8_t readback[count] = {};
+		driver.read(readback, address, count);
+		REQUIRE(memcmp(readback, data, count) == 0);
+		REQUIRE(chip.errors() == 0);
+	}
+
+	SECTION("bytes are transferred in buffers") {
+		uint8_t readback[count];
+		driver.read(readback, address, count);
+		REQUIRE(chip.transactions() == 1);
+		// command, address and data
+		REQUIRE(chip.clocks() == 8 * (4 + count));
+		REQUIRE(SPI.calls() == 4 + 1);
+
+		SPI.reset_calls();
+		driver.write(address, data, count);
+		REQUIRE(SPI.calls() == 4 + (count + DEVICE_BUFFER_SIZE - 1) /
+										DEVICE_BUFFER_SIZE);
+	}
+
+	SECTION("adjacent segments share a transaction") {
+		uint8_t readback[count];
+		const ReadSegment segments[] = {
+			{&readback[50], address + 50, 50},
+			{&readback[0], address, 50},
+		};
+		driver.readv(segments, 2);
+		REQUIRE(chip.transactions() == 1);
+		REQUIRE(chip.clocks() == 8 * (4 + count));
+	}
+}
+
+TEST_CASE("23LC1024 driver respects the operating mode", "[drivers]") {
+	constexpr int cs = 10;
+	constexpr Size count = 64;
+	// starts in the middle of a page, so the range touches three pages
+	Address address = Address(0x1010);
+
+	Mock23LC1024 chip{cs};
+	uint8_t data[count];
+	for (Size i = 0; i < count; i++) {
+		data[i] = uint8_t(255 - i);
+	}
+	uint8_t readback[count] = {};
+
+	auto transfer = [&](Driver_23LC1024::Mode mode) {
+		Driver_23LC1024 driver{cs, mode};
+		driver.begin();
+		chip.reset_counters();
+		driver.write(address, data, count);
+		driver.read(readback, address, count);
+		REQUIRE(memcmp(readback, data, count) == 0);
+		REQUIRE(chip.errors() == 0);
+	};
+
+	SECTION("sequential mode crosses pages") {
+		transfer(Driver_23LC1024::SEQUENTIAL);
+		REQUIRE(chip.mode() == Mock23LC1024::SEQUENTIAL);
+		REQUIRE(chip.transactions() == 2);
+	}
+
+	SECTION("page mode splits at page boundaries") {
+		transfer(Driver_23LC1024::PAGE);
+		REQUIRE(chip.mode() == Mock23LC1024::PAGE);
+		REQUIRE(chip.transactions() == 2 * 3);
+	}
+
+	SECTION("byte mode transfers single bytes") {
+		transfer(Driver_23LC1024::BYTE);
+		REQUIRE(chip.mode() == Mock23LC1024::BYTE);
+		REQUIRE(chip.transactions() == 2 * count);
+	}
+
+	SECTION("sequential transfers wrap around at the end") {
+		Driver_23LC1024 driver{cs};
+		driver.begin();
+		chip.reset_counters();
+		driver.write(Address(Driver_23LC1024::size() - 16), data, count);
+		REQUIRE(memcmp(chip.memory(), data + 16, count - 16) == 0);
+		REQUIRE(chip.transactions() == 2);
+	}
+}
+
+TEST_CASE("23LC1024 driver transfers in quad mode", "[drivers]") {
+	constexpr int cs = 10;
+	constexpr int sck = 13;
+	constexpr int sio[] = {11, 12, 20, 21};
+	constexpr Size count = 100;
+	Address address = Address(0x4321);
+
+	Mock23LC1024 chip{cs, sck, sio[0], sio[1], sio[2], sio[3]};
+	Driver_23LC1024 driver{cs, {sck, {sio[0], sio[1], sio[2], sio[3]}}};
+	driver.begin();
+	REQUIRE(chip.is_quad());
+	chip.reset_counters();
+
+	uint8_t data[count];
+	for (Size i = 0; i < count; i++) {
+		data[i] = uint8_t(i * 13 + 1);
+	}
+
+	SECTION("data reaches the chip") {
+		driver.write(address, data, count);
+		REQUIRE(memcmp(chip.memory() + address.value, data, count) == 0);
+
+		uint8_t readback[count] = {};
+		driver.read(readback, address, count);
+		REQUIRE(memcmp(readback, data, count) == 0);
+		REQUIRE(chip.errors() == 0);
+	}
+
+	SECTION("quad transfers take a quarter of the cycles") {
+		uint8_t readback[count];
+		driver.read(readback, address, count);
+		// command, address, dummy byte and data at two cycles per byte
+		REQUIRE(chip.clocks() == 2 * (4 + 1 + count));
+		REQUIRE(chip.clocks() < 8 * (4 + count) / 3);
+	}
+
+	SECTION("begin resets the chip to SPI mode") {
+		Driver_23LC1024 spi_driver{cs};
+		spi_driver.begin();
+		REQUIRE(!chip.is_quad());
+		spi_driver.write(address, data, count);
+		REQUIRE(memcmp(chip.memory() + address.value, data, count) == 0);
+		REQUIRE(chip.errors() == 0);
+	}
+}
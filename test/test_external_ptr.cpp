@@ -1,11 +1,20 @@
 #include "../allocators/bump_allocator.hpp"
+#include "../allocators/concurrent_allocator.hpp"
+#include "../allocators/segregated_allocator.hpp"
 #include "../external_ptr.hpp"
 #include "../helpers/template_allocator.hpp"
+#include "../layers/access_counter.hpp"
+#include "../layers/sharded_cache_layer.hpp"
 #include "../mocks/mock_memory_device.hpp"
+#include <atomic>
 #include <catch2/catch_all.hpp>
+#include <thread>
+#include <utility>
+#include <vector>
 
 using namespace rambock;
 using namespace allocators;
+using namespace layers;
 using namespace mocks;
 using namespace helpers;
 
@@ -95,3 +104,227 @@ TEST_CASE("test multi-stage pointer access", "[external_ptr]") {
 
 	REQUIRE(outer_ptr->data->i == 10);
 }
+
+TEST_CASE("External pointers only write back changes", "[external_ptr]") {
+	constexpr Size memory_size = 1024;
+	MockMemoryDevice<memory_size> memory_device{};
+	AccessCounter access_counter{memory_device};
+	BumpAllocator bump_allocator{access_counter, Address{memory_size}};
+	TemplateAllocator allocator{bump_allocator};
+
+	struct Data {
+		int a;
+		int b;
+	};
+
+	auto ptr = allocator.make_external<Data>(Data{1, 2});
+	access_counter.reset();
+
+	SECTION("Loading never writes") {
+		Data data = ptr.load();
+		REQUIRE(data.a == 1);
+		REQUIRE(data.b == 2);
+		REQUIRE(access_counter.reads() == 1);
+		REQUIRE(access_counter.writes() == 0);
+	}
+
+	SECTION("Storing never reads") {
+		ptr.store(Data{3, 4});
+		REQUIRE(access_counter.reads() == 0);
+		REQUIRE(access_counter.writes() == 1);
+		REQUIRE(ptr->b == 4);
+	}
+
+	SECTION("Storing into a live copy writes once") {
+		{
+			LocalCopy<Data> copy = *ptr;
+			ptr.store(Data{3, 4});
+		}
+		REQUIRE(access_counter.writes() == 1);
+		REQUIRE(ptr.load().a == 3);
+	}
+
+	SECTION("Unmodified copies are not written back") {
+		int a = ptr->a;
+		Data data = *ptr;
+		*ptr = data;
+		REQUIRE(a == 1);
+		REQUIRE(access_counter.writes() == 0);
+	}
+
+	SECTION("Modified copies write back changed bytes only") {
+		{
+			LocalCopy<Data> copy = *ptr;
+			copy->a = 5;
+			// changed behind the copy's back, must survive the write-back
+			const Data changed{1, 6};
+			memory_device.write(ptr.address(), &changed, sizeof(changed));
+		}
+		REQUIRE(access_counter.writes() == 1);
+		Data data = ptr.load();
+		REQUIRE(data.a == 5);
+		REQUIRE(data.b == 6);
+	}
+}
+
+TEST_CASE("Objects are stored without bookkeeping", "[external_ptr]") {
+	constexpr Size memory_size = 1024;
+	MockMemoryDevice<memory_size> memory_device{};
+	BumpAllocator bump_allocator{memory_device, Address{memory_size}};
+	TemplateAllocator allocator{bump_allocator};
+	helpers::PinTable &pins = helpers::PinTable::instance();
+
+	REQUIRE(external_ptr<int>::allocation_size == sizeof(int));
+
+	auto ptr = allocator.make_external<int>(1);
+	REQUIRE(pins.size() == 0);
+
+	SECTION("Copies of the same object alias") {
+		LocalCopy<int> first = *ptr;
+		LocalCopy<int> second = *ptr;
+		REQUIRE(first.is_first());
+		REQUIRE(!second.is_first());
+		REQUIRE(pins.size() == 1);
+
+		second = 2;
+		int value = first;
+		REQUIRE(value == 2);
+		REQUIRE(ptr.load() == 2);
+	}
+
+	SECTION("Moved copies stay pinned") {
+		LocalCopy<int> first = *ptr;
+		LocalCopy<int> second = *ptr;
+		LocalCopy<int> moved{std::move(first)};
+		REQUIRE(moved.is_first());
+		REQUIRE(!first.is_first());
+		REQUIRE(pins.size() == 1);
+
+		second = 6;
+		REQUIRE(int(moved) == 6);
+		REQUIRE(ptr.load() == 6);
+	}
+
+	SECTION("Stores update live copies") {
+		LocalCopy<int> copy = *ptr;
+		ptr.store(7);
+		REQUIRE(int(copy) == 7);
+		REQUIRE(ptr.load() == 7);
+	}
+
+	SECTION("Pins are released") {
+		{
+			LocalCopy<int> copy = *ptr;
+			copy = 3;
+		}
+		REQUIRE(pins.size() == 0);
+		REQUIRE(ptr.load() == 3);
+	}
+
+	SECTION("Copies work without room in the pin table") {
+		external_ptr<int> ptrs[PIN_TABLE_SIZE + 1];
+		for (auto &p : ptrs) {
+			p = allocator.make_external<int>(4);
+		}
+		{
+			// growing the vector moves the copies
+			std::vector<LocalCopy<int>> copies{};
+			for (auto &p : ptrs) {
+				copies.emplace_back(p.allocator().memory_device(), p.address());
+			}
+			REQUIRE(pins.size() == PIN_TABLE_SIZE);
+			copies[PIN_TABLE_SIZE] = 5;
+		}
+		REQUIRE(pins.size() == 0);
+		REQUIRE(ptrs[PIN_TABLE_SIZE].load() == 5);
+	}
+}
+
+TEST_CASE("External pointers work from several threads", "[external_ptr]") {
+	constexpr Size memory_size = 16 * 1024;
+	constexpr size_t thread_count = 4;
+	constexpr int increments = 1000;
+	static MockMemoryDevice<memory_size> memory_device{};
+	ShardedCacheLayer<16, 4> cache{memory_device};
+	SegregatedAllocator<> backend{cache, Address(memory_size)};
+	ConcurrentAllocator<> concurrent{backend};
+	TemplateAllocator allocator{concurrent};
+
+	std::atomic<int> failures{0};
+	std::vector<external_ptr<int>> ptrs(thread_count);
+	std::vector<std::thread> threads{};
+	for (size_t i = 0; i < thread_count; i++) {
+		threads.emplace_back([&, i] {
+			ptrs[i] = allocator.make_external<int>(0);
+			for (int n = 0; n < increments; n++) {
+				LocalCopy<int> first = *ptrs[i];
+				LocalCopy<int> second = *ptrs[i];
+				first = int(first) + 1;
+				// copies made on this thread alias each other
+				if (int(second) != n + 1 ||
+					helpers::PinTable::instance().size() != 1) {
+					failures++;
+				}
+			}
+		});
+	}
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+
+	REQUIRE(failures == 0);
+	REQUIRE(helpers::PinTable::instance().size() == 0);
+	for (external_ptr<int> &ptr : ptrs) {
+		REQUIRE(ptr.load() == increments);
+	}
+}
+
+TEST_CASE("Arrays are initialized in bulk", "[external_ptr]") {
+	constexpr Size memory_size = 64 * 1024;
+	constexpr size_t count = 10000;
+	static MockMemoryDevice<memory_size> memory_device{};
+	AccessCounter access_counter{memory_device};
+	BumpAllocator bump_allocator{access_counter, Address{memory_size}};
+	TemplateAllocator allocator{bump_allocator};
+
+	auto check = [&](external_ptr<int> ptr, int (*expected)(size_t)) {
+		static int values[count];
+		access_counter.read(values, ptr.address(), sizeof(values));
+		for (size_t i = 0; i < count; i++) {
+			REQUIRE(values[i] == expected(i));
+		}
+	};
+	const int max_writes = count * sizeof(int) / FILL_BUFFER_SIZE + 1;
+
+	SECTION("Arrays are default constructed") {
+		// make sure zeros were written rather than left over
+		const std::vector<uint8_t> garbage(memory_size, 0xff);
+		memory_device.write(Address(0), garbage.data(), memory_size);
+		auto ptr = allocator.make_array<int>(count);
+		// zeros are a single fill
+		REQUIRE(access_counter.writes() == 1);
+		check(ptr, [](size_t) { return 0; });
+	}
+
+	SECTION("Arrays are generated") {
+		auto ptr = allocator.make_array<int>(
+			count, [](size_t i) { return int(i) * 3; });
+		REQUIRE(access_counter.writes() <= max_writes);
+		check(ptr, [](size_t i) { return int(i) * 3; });
+	}
+
+	SECTION("Arrays are copied from ranges") {
+		std::vector<int> values(count);
+		for (size_t i = 0; i < count; i++) {
+			values[i] = int(count - i);
+		}
+		auto ptr = allocator.make_array<int>(values.begin(), values.end());
+		REQUIRE(access_counter.writes() <= max_writes);
+		check(ptr, [](size_t i) { return int(count - i); });
+	}
+
+	SECTION("Failed allocations return null") {
+		auto ptr = allocator.make_array<int>(memory_size);
+		REQUIRE(!ptr.address());
+	}
+}
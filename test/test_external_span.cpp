@@ -0,0 +1,94 @@
+#include "../allocators/bump_allocator.hpp"
+#include "../external_span.hpp"
+#include "../external_vector.hpp"
+#include "../layers/access_counter.hpp"
+#include "../mocks/mock_memory_device.hpp"
+#include <catch2/catch_all.hpp>
+#include <algorithm>
+#include <numeric>
+
+using namespace rambock;
+using namespace allocators;
+using namespace layers;
+using namespace mocks;
+
+TEST_CASE("External span buffers chunks", "[external_span]") {
+	constexpr Size memory_size = 4096;
+	constexpr size_t count = 100;
+	MockMemoryDevice<memory_size> memory_device{};
+	AccessCounter access_counter{memory_device};
+	BumpAllocator allocator{access_counter, Address(memory_size)};
+
+	external_vector<int> vector{allocator};
+	for (size_t i = 0; i < count; i++) {
+		vector.push_back(int(i));
+	}
+	using Span = external_span<int, 160>;
+	const size_t frames_per_chunk = 160 / external_ptr<int>::allocation_size;
+	const size_t chunks = (count + frames_per_chunk - 1) / frames_per_chunk;
+	REQUIRE(chunks > 1);
+	access_counter.reset();
+
+	SECTION("Reading transfers each chunk once") {
+		{
+			Span span{vector.data(), count};
+			REQUIRE(span.size() == count);
+			int sum = std::accumulate(span.begin(), span.end(), 0);
+			REQUIRE(sum == 99 * 100 / 2);
+		}
+		REQUIRE(access_counter.reads() == int(chunks));
+		REQUIRE(access_counter.writes() == 0);
+	}
+
+	SECTION("Only modified chunks are written back") {
+		{
+			Span span{vector.data(), count};
+			std::transform(span.begin(),
+						   span.end(),
+						   span.begin(),
+						   [](int value) { return 2 * value; });
+			span[0] = 7;
+		}
+		REQUIRE(access_counter.reads() == int(chunks) + 1);
+		REQUIRE(access_counter.writes() == int(chunks) + 1);
+		access_counter.reset();
+
+		{
+			Span span{vector.data(), count};
+			span[5] = 0;
+			span[6] = 1;
+			int value = span[count - 1];
+			REQUIRE(value == 2 * int(count - 1));
+		}
+		REQUIRE(access_counter.writes() == 1);
+
+		int values[count];
+		vector.read_range(0, values, count);
+		REQUIRE(values[0] == 7);
+		REQUIRE(values[5] == 0);
+		REQUIRE(values[6] == 1);
+		REQUIRE(values[7] == 14);
+	}
+
+	SECTION("Iterators are random access") {
+		Span span{vector.data(), count};
+		auto begin = span.begin();
+		auto end = span.end();
+		REQUIRE(end - begin == ptrdiff_t(count));
+		REQUIRE(int(begin[42]) == 42);
+		REQUIRE(int(*(end - 1)) == int(count) - 1);
+		REQUIRE(int(*(3 + begin)) == 3);
+		REQUIRE(begin < end);
+		auto found = std::find(begin, end, 77);
+		REQUIRE(found - begin == 77);
+		REQUIRE(std::is_sorted(begin, end));
+	}
+
+	SECTION("Flushing writes back early") {
+		Span span{vector.data(), count};
+		span[count - 1] = -1;
+		span.flush();
+		int value = vector[count - 1];
+		REQUIRE(value == -1);
+	}
+}
@@ -0,0 +1,133 @@
+#include "../allocators/simple_allocator.hpp"
+#include "../external_vector.hpp"
+#include "../layers/access_counter.hpp"
+#include "../mocks/mock_memory_device.hpp"
+#include <catch2/catch_all.hpp>
+#include <algorithm>
+#include <vector>
+
+using namespace rambock;
+using namespace allocators;
+using namespace layers;
+using namespace mocks;
+
+TEST_CASE("External vector manages elements", "[external_vector]") {
+	constexpr Size memory_size = 4096;
+	MockMemoryDevice<memory_size> memory_device{};
+	AccessCounter access_counter{memory_device};
+	SimpleAllocator allocator{access_counter, Address(memory_size)};
+	const Size free_bytes = allocator.get_free_bytes();
+
+	external_vector<int> vector{allocator};
+
+	auto contents = [&]() {
+		int values[64] = {};
+		size_t count = vector.read_range(0, values, 64);
+		REQUIRE(count == vector.size());
+		return std::vector<int>(values, values + count);
+	};
+
+	SECTION("Pushed elements can be read") {
+		for (int i = 0; i < 20; i++) {
+			REQUIRE(vector.push_back(i));
+		}
+		REQUIRE(vector.size() == 20);
+		REQUIRE(vector.capacity() >= 20);
+		for (int i = 0; i < 20; i++) {
+			int value = vector[i];
+			REQUIRE(value == i);
+		}
+		vector.pop_back();
+		REQUIRE(vector.size() == 19);
+	}
+
+	SECTION("Growth is amortized") {
+		size_t reallocations = 0, capacity = 0;
+		for (int i = 0; i < 64; i++) {
+			vector.push_back(i);
+			if (vector.capacity() != capacity) {
+				capacity = vector.capacity();
+				reallocations++;
+			}
+		}
+		REQUIRE(reallocations <= 5);
+		int values[64];
+		REQUIRE(vector.read_range(0, values, 64) == 64);
+		for (int i = 0; i < 64; i++) {
+			REQUIRE(values[i] == i);
+		}
+	}
+
+	SECTION("Elements are inserted and erased") {
+		const int values[] = {1, 2, 5};
+		REQUIRE(vector.assign(values, 3));
+		REQUIRE(vector.insert(2, 3));
+		const int more[] = {4, 4};
+		REQUIRE(vector.insert(3, more, 2));
+		REQUIRE(vector.insert(0, 0));
+		REQUIRE(contents() == std::vector<int>{0, 1, 2, 3, 4, 4, 5});
+
+		REQUIRE(vector.erase(4) == 1);
+		REQUIRE(vector.erase(0, 2) == 2);
+		REQUIRE(contents() == std::vector<int>{2, 3, 4, 5});
+		REQUIRE(vector.erase(3, 10) == 1);
+		REQUIRE(vector.erase(3) == 0);
+		REQUIRE(!vector.insert(4, 0));
+		REQUIRE(contents() == std::vector<int>{2, 3, 4});
+	}
+
+	SECTION("Ranges are transferred in chunks") {
+		int values[100];
+		for (int i = 0; i < 100; i++) {
+			values[i] = i;
+		}
+		REQUIRE(vector.resize(100));
+
+		access_counter.reset();
+		REQUIRE(vector.write_range(0, values, 100) == 100);
+		REQUIRE(access_counter.writes() < 100 / 2);
+		REQUIRE(access_counter.reads() == 0);
+
+		access_counter.reset();
+		int read[100] = {};
+		REQUIRE(vector.read_range(0, read, 100) == 100);
+		REQUIRE(access_counter.reads() < 100 / 2);
+		REQUIRE(std::equal(values, values + 100, read));
+
+		REQUIRE(vector.write_range(98, values, 10) == 2);
+		REQUIRE(vector.read_range(100, read, 10) == 0);
+	}
+
+	SECTION("Resizing fills new elements") {
+		REQUIRE(vector.resize(5, 7));
+		REQUIRE(vector.resize(2));
+		REQUIRE(vector.resize(4, 3));
+		REQUIRE(contents() == std::vector<int>{7, 7, 3, 3});
+	}
+
+	SECTION("Elements are accessible through pointers") {
+		vector.resize(4);
+		auto ptr = vector.data();
+		ptr[2] = 42;
+		int value = vector[2];
+		REQUIRE(value == 42);
+	}
+
+	SECTION("Failed allocations leave the vector unchanged") {
+		vector.resize(4, 1);
+		REQUIRE(!vector.reserve(memory_size));
+		REQUIRE(!vector.resize(memory_size));
+		REQUIRE(contents() == std::vector<int>{1, 1, 1, 1});
+	}
+
+	SECTION("Storage is released") {
+		{
+			external_vector<int> other{allocator};
+			other.resize(10);
+			vector = std::move(other);
+		}
+		REQUIRE(vector.size() == 10);
+		vector = external_vector<int>{allocator};
+		REQUIRE(allocator.get_free_bytes() == free_bytes);
+	}
+}
@@ -0,0 +1,112 @@
+#include "../allocators/simple_allocator.hpp"
+#include "../drivers/file_memory_device.hpp"
+#include "../drivers/mmap_memory_device.hpp"
+#include "../external_vector.hpp"
+#include <catch2/catch_all.hpp>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace rambock;
+using namespace allocators;
+
+namespace {
+
+/** Temporary file removed once out of scope
+ */
+struct TemporaryFile {
+	TemporaryFile() {
+		const int fd = mkstemp(path);
+		if (fd >= 0) {
+			close(fd);
+		}
+	}
+	~TemporaryFile() { unlink(path); }
+
+	char path[32] = "/tmp/rambock_XXXXXX";
+};
+
+} // namespace
+
+TEST_CASE("file memory device stores data in a file", "[drivers]") {
+	constexpr Size memory_size = 1024 * 1024;
+	const int values[] = {1, 2, 3, 4};
+	int readback[4] = {};
+	Address address = Address(memory_size / 2);
+
+	TemporaryFile file{};
+	FileMemoryDevice device{file.path, memory_size};
+	REQUIRE(device.is_open());
+
+	SECTION("data survives reopening") {
+		REQUIRE(device.write(address, values, sizeof(values)) == address);
+		REQUIRE(device.sync());
+
+		FileMemoryDevice reopened{file.path, memory_size};
+		REQUIRE(reopened.read(readback, address, sizeof(readback)));
+		REQUIRE(memcmp(readback, values, sizeof(values)) == 0);
+	}
+
+	SECTION("out of bounds accesses fail") {
+		Address end = Address(memory_size);
+		REQUIRE(!device.write(end - 4, values, sizeof(values)));
+		REQUIRE(!device.read(readback, end, 1));
+		REQUIRE(device.read(readback, end - 4, 4));
+	}
+
+	SECTION("ranges are moved and filled") {
+		device.write(address, values, sizeof(values));
+		device.move(address + 4, address, sizeof(values));
+		device.read(readback, address + 4, sizeof(readback));
+		REQUIRE(memcmp(readback, values, sizeof(values)) == 0);
+
+		device.fill(address, 0, sizeof(values));
+		device.read(readback, address, sizeof(readback));
+		REQUIRE(readback[0] == 0);
+		REQUIRE(readback[3] == 0);
+	}
+
+	SECTION("containers work on files") {
+		SimpleAllocator allocator{device, Address(memory_size)};
+		external_vector<int> vector{allocator};
+		REQUIRE(vector.resize(100000, 7));
+		REQUIRE(vector.insert(0, values, 4));
+		int first[5];
+		REQUIRE(vector.read_range(0, first, 5) == 5);
+		REQUIRE(first[3] == 4);
+		REQUIRE(first[4] == 7);
+	}
+}
+
+TEST_CASE("mmap memory device maps memory", "[drivers]") {
+	constexpr Size memory_size = 1024 * 1024;
+	const int values[] = {1, 2, 3, 4};
+	int readback[4] = {};
+	Address address = Address(memory_size / 2);
+
+	SECTION("files are mapped") {
+		TemporaryFile file{};
+		{
+			MmapMemoryDevice device{file.path, memory_size};
+			REQUIRE(device.is_open());
+			device.write(address, values, sizeof(values));
+			REQUIRE(device.sync());
+		}
+		FileMemoryDevice file_device{file.path, memory_size};
+		file_device.read(readback, address, sizeof(readback));
+		REQUIRE(memcmp(readback, values, sizeof(values)) == 0);
+	}
+
+	SECTION("anonymous memory is accessed without copies") {
+		MmapMemoryDevice device{memory_size};
+		REQUIRE(device.is_open());
+		device.write(address, values, sizeof(values));
+		REQUIRE(memcmp(device.data(address), values, sizeof(values)) == 0);
+
+		device.copy(address + 16, address, sizeof(values));
+		device.read(readback, address + 16, sizeof(readback));
+		REQUIRE(memcmp(readback, values, sizeof(values)) == 0);
+
+		REQUIRE(!device.write(Address(memory_size), values, 1));
+		REQUIRE(device.data(Address(memory_size + 1)) == nullptr);
+	}
+}
@@ -0,0 +1,104 @@
+#include "../layers/access_counter.hpp"
+#include "../layers/lru_cache_layer.hpp"
+#include "../mocks/mock_memory_device.hpp"
+#include <catch2/catch_all.hpp>
+
+using namespace rambock;
+using namespace mocks;
+using namespace layers;
+
+TEST_CASE("lru cache layer caches accesses", "[layers]") {
+	constexpr Size memory_size = 1024;
+	constexpr Size line_size = 16;
+	constexpr Size line_count = 4;
+	Address low_address = Address{8};
+	Address high_address = Address{512};
+
+	MockMemoryDevice<memory_size> mock_memory_device{};
+	AccessCounter access_counter{mock_memory_device};
+	LRUCacheLayer<line_size, line_count, 2> cache_layer{access_counter};
+
+	SECTION("initial cache is empty") {
+		REQUIRE(access_counter.reads() == 0);
+		REQUIRE(access_counter.writes() == 0);
+		REQUIRE(!cache_layer.is_cached(low_address, 1));
+		REQUIRE(!cache_layer.dirty());
+	}
+
+	SECTION("alternating regions stay resident") {
+		int data = 0;
+		cache_layer.read(&data, low_address, sizeof(data));
+		cache_layer.read(&data, high_address, sizeof(data));
+		int reads_after_fetch = access_counter.reads();
+
+		for (int i = 0; i < 10; i++) {
+			cache_layer.read(&data, low_address, sizeof(data));
+			cache_layer.read(&data, high_address, sizeof(data));
+		}
+
+		REQUIRE(access_counter.reads() == reads_after_fetch);
+		REQUIRE(cache_layer.hits() == 20);
+		REQUIRE(cache_layer.misses() == 2);
+	}
+
+	SECTION("accesses may span lines") {
+		uint8_t bytes[line_size + 4];
+		for (Size i = 0; i < sizeof(bytes); i++) {
+			bytes[i] = static_cast<uint8_t>(i);
+		}
+		cache_layer.write(low_address, &bytes, sizeof(bytes));
+		REQUIRE(cache_layer.is_cached(low_address, sizeof(bytes)));
+
+		uint8_t readback[sizeof(bytes)] = {};
+		cache_layer.read(&readback, low_address, sizeof(readback));
+		REQUIRE(memcmp(bytes, readback, sizeof(bytes)) == 0);
+	}
+
+	SECTION("least recently used line is evicted") {
+		// Addresses mapping to the same set with two ways
+		Address a = Address{0};
+		Address b = a + line_size * line_count / 2;
+		Address c = b + line_size * line_count / 2;
+		int data = 0;
+
+		cache_layer.read(&data, a, sizeof(data));
+		cache_layer.read(&data, b, sizeof(data));
+		cache_layer.read(&data, a, sizeof(data));
+		cache_layer.read(&data, c, sizeof(data));
+
+		REQUIRE(cache_layer.is_cached(a, sizeof(data)));
+		REQUIRE(!cache_layer.is_cached(b, sizeof(data)));
+		REQUIRE(cache_layer.is_cached(c, sizeof(data)));
+	}
+
+	SECTION("only dirty lines are written back") {
+		int data = 10;
+		cache_layer.read(&data, high_address, sizeof(data));
+		cache_layer.write(low_address, &data, sizeof(data));
+		REQUIRE(cache_layer.dirty());
+
+		cache_layer.flush();
+		REQUIRE(!cache_layer.dirty());
+		REQUIRE(access_counter.writes() == 1);
+
+		int readback = 0;
+		mock_memory_device.read(&readback, low_address, sizeof(readback));
+		REQUIRE(readback == data);
+	}
+
+	SECTION("large accesses bypass the cache consistently") {
+		int data = 20;
+		cache_layer.write(low_address, &data, sizeof(data));
+
+		uint8_t large[line_size * line_count * 2];
+		cache_layer.read(&large, Address::null(), sizeof(large));
+		int readback = 0;
+		memcpy(&readback, &large[low_address.value], sizeof(readback));
+		REQUIRE(readback == data);
+
+		memset(large, 0, sizeof(large));
+		cache_layer.write(Address::null(), &large, sizeof(large));
+		cache_layer.read(&readback, low_address, sizeof(readback));
+		REQUIRE(readback == 0);
+	}
+}
@@ -0,0 +1,86 @@
+#include "../layers/access_counter.hpp"
+#include "../layers/prefetch_layer.hpp"
+#include "../mocks/mock_memory_device.hpp"
+#include <catch2/catch_all.hpp>
+
+using namespace rambock;
+using namespace mocks;
+using namespace layers;
+
+TEST_CASE("prefetch layer reads ahead", "[layers]") {
+	constexpr Size memory_size = 1024;
+	constexpr Size buffer_size = 64;
+	constexpr Size max_depth = 8;
+
+	MockMemoryDevice<memory_size> mock_memory_device{};
+	AccessCounter access_counter{mock_memory_device};
+	PrefetchLayer<buffer_size> prefetch_layer{
+		access_counter, Address{memory_size}, max_depth};
+
+	for (Size i = 0; i < memory_size / sizeof(int); i++) {
+		int value = static_cast<int>(i);
+		mock_memory_device.write(
+			Address::null() + i * sizeof(int), &value, sizeof(value));
+	}
+
+	auto scan = [&](Size stride, Size n) {
+		bool valid = true;
+		for (Size i = 0; i < n; i++) {
+			Address address = Address::null() + i * stride;
+			int value = 0;
+			prefetch_layer.read(&value, address, sizeof(value));
+			valid &= value == static_cast<int>(address.value / sizeof(int));
+		}
+		return valid;
+	};
+
+	SECTION("sequential scans are detected") {
+		REQUIRE(scan(sizeof(int), 128));
+		REQUIRE(prefetch_layer.stride() == sizeof(int));
+		REQUIRE(prefetch_layer.hits() > 0);
+		REQUIRE(access_counter.reads() < 128);
+	}
+
+	SECTION("strided scans are detected") {
+		REQUIRE(scan(3 * sizeof(int), 64));
+		REQUIRE(prefetch_layer.stride() == 3 * sizeof(int));
+		REQUIRE(access_counter.reads() < 64);
+	}
+
+	SECTION("depth grows while predictions hit") {
+		scan(sizeof(int), 128);
+		REQUIRE(prefetch_layer.depth() == max_depth);
+	}
+
+	SECTION("random accesses do not prefetch") {
+		const Size addresses[] = {40, 400, 12, 900, 200, 8, 640};
+		for (Size address : addresses) {
+			int value = 0;
+			prefetch_layer.read(&value, Address{address}, sizeof(value));
+		}
+		REQUIRE(prefetch_layer.hits() == 0);
+		REQUIRE(!prefetch_layer.is_buffered(Address{644}, sizeof(int)));
+	}
+
+	SECTION("writes keep the buffer consistent") {
+		scan(sizeof(int), 16);
+		Address address = Address::null() + 16 * sizeof(int);
+		REQUIRE(prefetch_layer.is_buffered(address, sizeof(int)));
+
+		int value = -1;
+		prefetch_layer.write(address, &value, sizeof(value));
+		int readback = 0;
+		prefetch_layer.read(&readback, address, sizeof(readback));
+		REQUIRE(readback == value);
+	}
+
+	SECTION("prefetches stop at the end of memory") {
+		Address near_end = Address{memory_size - 32 * sizeof(int)};
+		for (Size i = 0; i < 32; i++) {
+			int value = 0;
+			prefetch_layer.read(
+				&value, near_end + i * sizeof(int), sizeof(value));
+		}
+		REQUIRE(!prefetch_layer.is_buffered(Address{memory_size}, 1));
+	}
+}
@@ -0,0 +1,52 @@
+#include "../allocators/segregated_allocator.hpp"
+#include "../layers/access_counter.hpp"
+#include "../mocks/mock_memory_device.hpp"
+#include <catch2/catch_all.hpp>
+
+using namespace rambock;
+using namespace allocators;
+using namespace layers;
+using namespace mocks;
+
+TEST_CASE("Segregated allocator costs constant transactions",
+		  "[segregated_allocator]") {
+	constexpr Size memory_size = 4096;
+	MockMemoryDevice<memory_size> memory_device{};
+	AccessCounter access_counter{memory_device};
+	SegregatedAllocator<> allocator{access_counter, Address(memory_size)};
+
+	Address addresses[50];
+	for (Address &address : addresses) {
+		address = allocator.allocate(20);
+	}
+
+	SECTION("Freeing reads the header and writes the link") {
+		access_counter.reset();
+		allocator.free(addresses[25]);
+		REQUIRE(access_counter.reads() == 1);
+		REQUIRE(access_counter.writes() == 1);
+	}
+
+	SECTION("Reusing a free block reads its link") {
+		allocator.free(addresses[25]);
+		access_counter.reset();
+		Address address = allocator.allocate(20);
+		REQUIRE(address == addresses[25]);
+		REQUIRE(access_counter.reads() == 1);
+		REQUIRE(access_counter.writes() == 0);
+	}
+
+	SECTION("Larger free blocks are split when memory runs out") {
+		Size free_bytes = allocator.get_free_bytes();
+		Address large = allocator.allocate(free_bytes / 2);
+		while (allocator.allocate(100)) {
+		}
+		while (allocator.allocate(4)) {
+		}
+		allocator.free(large);
+
+		Address small = allocator.allocate(4);
+		REQUIRE(small == large);
+		REQUIRE(allocator.allocate(100));
+	}
+}
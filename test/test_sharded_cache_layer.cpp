@@ -0,0 +1,87 @@
+#include "../layers/access_counter.hpp"
+#include "../layers/sharded_cache_layer.hpp"
+#include "../mocks/mock_memory_device.hpp"
+#include <catch2/catch_all.hpp>
+#include <thread>
+#include <vector>
+
+using namespace rambock;
+using namespace mocks;
+using namespace layers;
+
+TEST_CASE("sharded cache layer caches accesses", "[layers]") {
+	constexpr Size memory_size = 4096;
+	constexpr Size line_size = 16;
+	Address address = Address(40);
+
+	MockMemoryDevice<memory_size> mock_memory_device{};
+	AccessCounter access_counter{mock_memory_device};
+	ShardedCacheLayer<line_size, 2, 4> cache_layer{access_counter};
+
+	SECTION("cached lines hit the cache") {
+		int value = 5;
+		cache_layer.write(address, &value, sizeof(value));
+		REQUIRE(cache_layer.is_cached(address, sizeof(value)));
+
+		int reads_before = access_counter.reads();
+		int readback = 0;
+		cache_layer.read(&readback, address, sizeof(readback));
+		REQUIRE(readback == value);
+		REQUIRE(access_counter.reads() == reads_before);
+		REQUIRE(cache_layer.hits() == 1);
+	}
+
+	SECTION("accesses spanning shards are split into lines") {
+		uint8_t data[3 * line_size];
+		for (size_t i = 0; i < sizeof(data); i++) {
+			data[i] = uint8_t(i + 1);
+		}
+		cache_layer.write(address, data, sizeof(data));
+		cache_layer.flush();
+
+		uint8_t readback[sizeof(data)] = {};
+		mock_memory_device.read(readback, address, sizeof(readback));
+		REQUIRE(memcmp(readback, data, sizeof(data)) == 0);
+	}
+
+	SECTION("evicted lines are written back") {
+		for (Size i = 0; i < 64; i++) {
+			int value = int(i);
+			cache_layer.write(Address(i * line_size), &value, sizeof(value));
+		}
+		cache_layer.invalidate();
+		for (Size i = 0; i < 64; i++) {
+			int value = -1;
+			mock_memory_device.read(
+				&value, Address(i * line_size), sizeof(value));
+			REQUIRE(value == int(i));
+		}
+	}
+
+	SECTION("threads access disjoint ranges concurrently") {
+		constexpr size_t thread_count = 4;
+		constexpr Size range = memory_size / thread_count;
+		std::vector<std::thread> threads;
+		bool failed[thread_count] = {};
+		for (size_t t = 0; t < thread_count; t++) {
+			threads.emplace_back([&, t] {
+				const Address begin = Address(Size(t) * range);
+				for (Size offset = 0; offset < range; offset += sizeof(int)) {
+					const int value = int(t << 16 | offset);
+					cache_layer.write(begin + offset, &value, sizeof(value));
+				}
+				for (Size offset = 0; offset < range; offset += sizeof(int)) {
+					int value = 0;
+					cache_layer.read(&value, begin + offset, sizeof(value));
+					failed[t] |= value != int(t << 16 | offset);
+				}
+			});
+		}
+		for (std::thread &thread : threads) {
+			thread.join();
+		}
+		for (bool thread_failed : failed) {
+			REQUIRE(!thread_failed);
+		}
+	}
+}
@@ -1,9 +1,12 @@
 #include "../allocators/simple_allocator.hpp"
+#include "../layers/access_counter.hpp"
 #include "../mocks/mock_memory_device.hpp"
 #include <catch2/catch_all.hpp>
+#include <cstring>
 
 using namespace rambock;
 using namespace allocators;
+using namespace layers;
 using namespace mocks;
 
 TEST_CASE("Simple allocator allocates memory", "[simple_allocator]") {
@@ -11,53 +14,64 @@ TEST_CASE("Simple allocator allocates memory", "[simple_allocator]") {
 	MockMemoryDevice<memory_size> memory_device{};
 	SimpleAllocator allocator{memory_device, Address(memory_size)};
 
-	SECTION("Allocation returns an address") {
-		Address address = allocator.allocate(100);
-		REQUIRE(address);
-	}
-
-	SECTION("Allocations do not overlap") {
+	SECTION("Allocations are placed in ascending order") {
 		Address a = allocator.allocate(100);
 		Address b = allocator.allocate(100);
 
 		REQUIRE(a + 100 < b);
 	}
 
-	SECTION("Freed memory is reused") {
-		Address a = allocator.allocate(100);
+	SECTION("Freed memory is reused exactly") {
+		allocator.allocate(100);
 		Address b = allocator.allocate(100);
 		allocator.free(b);
 		Address c = allocator.allocate(100);
 		REQUIRE(b == c);
 	}
+}
 
-	SECTION("Allocations count against free bytes") {
-		Size free_bytes = allocator.get_free_bytes();
-		allocator.allocate(100);
-		REQUIRE(allocator.get_free_bytes() < free_bytes);
-	}
+TEST_CASE("Simple allocator can shadow headers locally", "[simple_allocator]") {
+	constexpr Size memory_size = 1024;
+	MockMemoryDevice<memory_size> device_memory{}, shadow_memory{};
+	AccessCounter access_counter{shadow_memory};
+	SimpleAllocator device_allocator{device_memory, Address(memory_size)};
+	SimpleAllocator shadow_allocator{access_counter,
+									 Address(memory_size),
+									 SimpleAllocator::SHADOW_HEADERS};
 
-	SECTION("Frees count towards free bytes") {
-		Address address = allocator.allocate(100);
-		Size before = allocator.get_free_bytes();
-		allocator.free(address);
-		Size after = allocator.get_free_bytes();
-		REQUIRE(before < after);
+	SECTION("Shadowed allocations never read from the device") {
+		Address a = shadow_allocator.allocate(100);
+		Address b = shadow_allocator.allocate(100);
+		shadow_allocator.free(a);
+		shadow_allocator.allocate(50);
+		shadow_allocator.free(b);
+		REQUIRE(access_counter.reads() == 0);
+		REQUIRE(access_counter.writes() > 0);
 	}
 
-	SECTION("Full free reclaims full memory") {
-		Size before = allocator.get_free_bytes();
-		Address address = allocator.allocate(100);
-		allocator.free(address);
-		Size after = allocator.get_free_bytes();
+	SECTION("Shadowed allocations behave like device allocations") {
+		Address device_addresses[8], shadow_addresses[8];
+		for (int i = 0; i < 8; i++) {
+			device_addresses[i] = device_allocator.allocate(10 * i + 1);
+			shadow_addresses[i] = shadow_allocator.allocate(10 * i + 1);
+		}
+		for (int i = 1; i < 8; i += 2) {
+			REQUIRE(device_allocator.free(device_addresses[i]) ==
+					shadow_allocator.free(shadow_addresses[i]));
+		}
+		REQUIRE(device_allocator.allocate(15) == shadow_allocator.allocate(15));
+		REQUIRE(device_allocator.get_free_bytes() ==
+				shadow_allocator.get_free_bytes());
 
-		REQUIRE(before == after);
+		// headers on the device are identical, so both modes can be mixed
+		uint8_t device_bytes[memory_size], shadow_bytes[memory_size];
+		device_memory.read(device_bytes, Address(0), memory_size);
+		shadow_memory.read(shadow_bytes, Address(0), memory_size);
+		REQUIRE(std::memcmp(device_bytes, shadow_bytes, memory_size) == 0);
 	}
 
-	SECTION("Too large allocations fail") {
-		Size before = allocator.get_free_bytes();
-		Address address = allocator.allocate(memory_size * 2);
-		REQUIRE(!address);
-		REQUIRE(allocator.get_free_bytes() == before);
+	SECTION("Footprint is reported") {
+		REQUIRE(device_allocator.shadow_footprint() == 0);
+		REQUIRE(shadow_allocator.shadow_footprint() > 0);
 	}
 }
@@ -0,0 +1,88 @@
+#include "../helpers/threaded_device.hpp"
+#include "../layers/access_counter.hpp"
+#include "../layers/striped_device.hpp"
+#include "../mocks/mock_memory_device.hpp"
+#include <catch2/catch_all.hpp>
+
+using namespace rambock;
+using namespace helpers;
+using namespace layers;
+using namespace mocks;
+
+TEST_CASE("striped device spreads accesses", "[layers]") {
+	constexpr Size device_size = 256;
+	constexpr Size stripe_size = 16;
+	constexpr size_t device_count = 4;
+	using Mock = MockMemoryDevice<device_size>;
+
+	Mock mocks[device_count];
+	AccessCounter first{mocks[0]}, second{mocks[1]}, third{mocks[2]},
+		fourth{mocks[3]};
+	AccessCounter *const counters[] = {&first, &second, &third, &fourth};
+	MemoryDevice *const devices[] = {&first, &second, &third, &fourth};
+
+	uint8_t data[device_count * device_size];
+	for (size_t i = 0; i < sizeof(data); i++) {
+		data[i] = uint8_t(i * 5 + 1);
+	}
+	uint8_t readback[sizeof(data)] = {};
+
+	SECTION("concatenated devices add up") {
+		StripedDevice<device_count> device{devices, device_size};
+		REQUIRE(device.size() == device_count * device_size);
+
+		Address address = Address(device_size - 8);
+		device.write(address, data, 16);
+		mocks[0].read(readback, Address(device_size - 8), 8);
+		mocks[1].read(readback + 8, Address(0), 8);
+		REQUIRE(memcmp(readback, data, 16) == 0);
+
+		REQUIRE(!device.write(Address(device.size() - 1), data, 2));
+		REQUIRE(!device.read(readback, Address(device.size()), 1));
+	}
+
+	SECTION("stripes are dealt out evenly") {
+		StripedDevice<device_count> device{devices, device_size, stripe_size};
+		const Size count = 4 * device_count * stripe_size;
+		device.write(Address(0), data, count);
+
+		for (size_t i = 0; i < device_count; i++) {
+			// all stripes of a device are written at once
+			REQUIRE(counters[i]->writes() == 1);
+			mocks[i].read(readback, Address(stripe_size), stripe_size);
+			REQUIRE(memcmp(readback,
+						   data + (device_count + i) * stripe_size,
+						   stripe_size) == 0);
+		}
+
+		device.read(readback, Address(0), count);
+		REQUIRE(memcmp(readback, data, count) == 0);
+		for (AccessCounter *counter : counters) {
+			REQUIRE(counter->reads() == 1);
+		}
+	}
+
+	SECTION("unaligned ranges are split at stripes") {
+		StripedDevice<device_count> device{devices, device_size, stripe_size};
+		device.write(Address(0), data, device.size());
+		device.fill(Address(stripe_size - 4), 0, 8);
+		device.read(readback, Address(0), device.size());
+		memset(data + stripe_size - 4, 0, 8);
+		REQUIRE(memcmp(readback, data, device.size()) == 0);
+	}
+
+	SECTION("asynchronous devices are accessed concurrently") {
+		ThreadedDevice threaded_first{mocks[0]}, threaded_second{mocks[1]},
+			threaded_third{mocks[2]}, threaded_fourth{mocks[3]};
+		ThreadedDevice *const async_devices[] = {&threaded_first,
+												 &threaded_second,
+												 &threaded_third,
+												 &threaded_fourth};
+		StripedDevice<device_count, ThreadedDevice> device{
+			async_devices, device_size, stripe_size};
+
+		device.write(Address(8), data, device.size() - 8);
+		device.read(readback, Address(8), device.size() - 8);
+		REQUIRE(memcmp(readback, data, device.size() - 8) == 0);
+	}
+}
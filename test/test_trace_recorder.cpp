@@ -0,0 +1,166 @@
+#include "../helpers/trace_replay.hpp"
+#include "../layers/cache_layer.hpp"
+#include "../layers/trace_recorder.hpp"
+#include "../mocks/mock_memory_device.hpp"
+#include <catch2/catch_all.hpp>
+#include <vector>
+
+using namespace rambock;
+using namespace layers;
+using namespace mocks;
+
+namespace {
+
+// advances by 10 ticks on every call
+uint64_t ticks = 0;
+uint64_t fake_clock() { return ticks += 10; }
+
+void collect(const uint8_t *data, size_t size, void *context) {
+	auto &trace = *static_cast<std::vector<uint8_t> *>(context);
+	trace.insert(trace.end(), data, data + size);
+}
+
+} // namespace
+
+TEST_CASE("trace recorder logs accesses", "[layers]") {
+	constexpr Size memory_size = 1024;
+	uint8_t buffer[100] = {};
+	std::vector<uint8_t> trace{};
+
+	MockMemoryDevice<memory_size> memory_device{};
+	ticks = 0;
+
+	SECTION("accesses are passed on and decoded in order") {
+		{
+			TraceRecorder recorder{
+				memory_device, &collect, &trace, &fake_clock};
+			const uint8_t value = 42;
+			recorder.write(Address(100), &value, 1);
+			recorder.read(buffer, Address(100), 1);
+			REQUIRE(buffer[0] == 42);
+
+			recorder.fill(Address(200), 7, 50);
+			recorder.copy(Address(300), Address(200), 50);
+			recorder.move(Address(90), Address(100), 20);
+
+			uint8_t other = 0;
+			const ReadSegment segments[] = {{buffer, Address(300), 10},
+											{&other, Address(12), 1}};
+			recorder.readv(segments, 2);
+			REQUIRE(recorder.records() == 7);
+			// records are buffered until the recorder is flushed or destroyed
+			REQUIRE(trace.empty());
+		}
+		REQUIRE(!trace.empty());
+
+		TraceRecorder::Reader reader{trace.data(), trace.size()};
+		TraceRecorder::Record record{};
+		REQUIRE(reader.next(record));
+		REQUIRE(record.operation == TraceRecorder::WRITE);
+		REQUIRE(record.address == Address(100));
+		REQUIRE(record.size == 1);
+		REQUIRE(record.time == 10);
+
+		REQUIRE(reader.next(record));
+		REQUIRE(record.operation == TraceRecorder::READ);
+		REQUIRE(record.address == Address(100));
+		REQUIRE(record.time == 20);
+
+		REQUIRE(reader.next(record));
+		REQUIRE(record.operation == TraceRecorder::FILL);
+		REQUIRE(record.address == Address(200));
+		REQUIRE(record.size == 50);
+		REQUIRE(record.value == 7);
+
+		REQUIRE(reader.next(record));
+		REQUIRE(record.operation == TraceRecorder::COPY);
+		REQUIRE(record.address == Address(300));
+		REQUIRE(record.source == Address(200));
+
+		REQUIRE(reader.next(record));
+		REQUIRE(record.operation == TraceRecorder::MOVE);
+		REQUIRE(record.address == Address(90));
+		REQUIRE(record.source == Address(100));
+		REQUIRE(record.size == 20);
+
+		REQUIRE(reader.next(record));
+		REQUIRE(record.operation == TraceRecorder::READ);
+		REQUIRE(record.address == Address(300));
+		REQUIRE(reader.next(record));
+		REQUIRE(record.address == Address(12));
+		REQUIRE(record.time == 70);
+
+		REQUIRE(!reader.next(record));
+		REQUIRE(reader.done());
+	}
+
+	SECTION("sequential accesses are compact") {
+		TraceRecorder recorder{memory_device, &collect, &trace, &fake_clock};
+		for (Size i = 0; i < 100; i++) {
+			recorder.read(buffer, Address(4 * i), 4);
+		}
+		recorder.flush();
+		// operation, address, size and time take one byte each
+		REQUIRE(trace.size() == 4 * 100);
+	}
+
+	SECTION("truncated streams are detected") {
+		{
+			TraceRecorder recorder{
+				memory_device, &collect, &trace, &fake_clock};
+			recorder.write(Address(1000), buffer, 100);
+		}
+		trace.pop_back();
+		TraceRecorder::Reader reader{trace.data(), trace.size()};
+		TraceRecorder::Record record{};
+		REQUIRE(!reader.next(record));
+		REQUIRE(!reader.done());
+	}
+}
+
+TEST_CASE("trace replay reports totals", "[layers]") {
+	constexpr Size memory_size = 1024;
+	uint8_t buffer[16] = {};
+	std::vector<uint8_t> trace{};
+
+	{
+		MockMemoryDevice<memory_size> memory_device{};
+		TraceRecorder recorder{memory_device, &collect, &trace, &fake_clock};
+		for (int pass = 0; pass < 4; pass++) {
+			for (Size i = 0; i < 64; i++) {
+				recorder.read(buffer, Address(4 * i), 4);
+			}
+		}
+		recorder.write(Address(512), buffer, 16);
+	}
+
+	MockMemoryDevice<memory_size> memory_device{};
+	AccessProfiler bus{memory_device, &fake_clock};
+
+	SECTION("every record reaches an uncached device") {
+		const helpers::ReplayResult result =
+			helpers::replay(trace.data(), trace.size(), bus, &bus, &fake_clock);
+		REQUIRE(result.complete);
+		REQUIRE(result.records == 4 * 64 + 1);
+		REQUIRE(result.bytes == 4 * 64 * 4 + 16);
+		REQUIRE(result.transactions == 4 * 64 + 1);
+		REQUIRE(result.transferred == result.bytes);
+		REQUIRE(result.time > 0);
+	}
+
+	SECTION("a cache saves transactions") {
+		CacheLayer<256> cache{bus};
+		const helpers::ReplayResult result = helpers::replay(
+			trace.data(), trace.size(), cache, &bus, &fake_clock);
+		REQUIRE(result.records == 4 * 64 + 1);
+		REQUIRE(result.transactions < 4 * 64);
+	}
+
+	SECTION("replays stop at malformed records") {
+		trace.pop_back();
+		const helpers::ReplayResult result =
+			helpers::replay(trace.data(), trace.size(), bus, &bus, &fake_clock);
+		REQUIRE(!result.complete);
+		REQUIRE(result.records == 4 * 64);
+	}
+}
@@ -0,0 +1,173 @@
+#include "../allocators/virtual_allocator.hpp"
+#include "../helpers/template_allocator.hpp"
+#include "../layers/access_counter.hpp"
+#include "../mocks/mock_memory_device.hpp"
+#include <catch2/catch_all.hpp>
+
+using namespace rambock;
+using namespace allocators;
+using namespace helpers;
+using namespace layers;
+using namespace mocks;
+
+TEST_CASE("Virtual allocator maps pages lazily", "[virtual_allocator]") {
+	constexpr Size memory_size = 4096;
+	constexpr Size page_size = 64;
+	MockMemoryDevice<memory_size> memory_device{};
+	AccessCounter access_counter{memory_device};
+	VirtualAllocator<page_size, 4> allocator{access_counter,
+											 Address(memory_size)};
+
+	SECTION("Allocation returns an address") {
+		Address address = allocator.allocate(100);
+		REQUIRE(address);
+	}
+
+	SECTION("Allocations do not overlap") {
+		Address a = allocator.allocate(100);
+		Address b = allocator.allocate(100);
+
+		REQUIRE(a + 100 < b);
+	}
+
+	SECTION("Virtual space exceeds physical memory") {
+		const Size large = 1024 * 1024;
+		Address address = allocator.allocate(large);
+		REQUIRE(address);
+
+		// touch a few pages spread across the allocation
+		for (Size offset = 0; offset < large; offset += large / 8) {
+			Size value = offset;
+			REQUIRE(allocator.write(address + offset, &value, sizeof(value)));
+		}
+		for (Size offset = 0; offset < large; offset += large / 8) {
+			Size value = 0;
+			allocator.read(&value, address + offset, sizeof(value));
+			REQUIRE(value == offset);
+		}
+	}
+
+	SECTION("Untouched pages read as zeros") {
+		Address address = allocator.allocate(4 * page_size);
+		Size before = allocator.get_free_bytes();
+
+		uint8_t data[page_size];
+		memset(data, 0xff, sizeof(data));
+		allocator.read(&data, address + 2 * page_size, sizeof(data));
+
+		REQUIRE(data[0] == 0);
+		REQUIRE(data[page_size - 1] == 0);
+		REQUIRE(allocator.get_free_bytes() == before);
+	}
+
+	SECTION("Freed pages are reclaimed") {
+		Size before = allocator.get_free_bytes();
+		Address address = allocator.allocate(8 * page_size);
+		uint8_t data[8 * page_size] = {};
+		allocator.write(address, &data, sizeof(data));
+		Size during = allocator.get_free_bytes();
+		REQUIRE(during < before);
+
+		allocator.free(address);
+		REQUIRE(allocator.get_free_bytes() - during >= 8 * page_size);
+	}
+
+	SECTION("Shared pages survive freeing a neighbor") {
+		Address a = allocator.allocate(sizeof(int));
+		Address b = allocator.allocate(sizeof(int));
+		int value = 42;
+		allocator.write(b, &value, sizeof(value));
+
+		allocator.free(a);
+
+		int readback = 0;
+		allocator.read(&readback, b, sizeof(readback));
+		REQUIRE(readback == value);
+	}
+
+	SECTION("Freeing twice is ignored") {
+		Address a = allocator.allocate(8);
+		Address b = allocator.allocate(8);
+		int value = 42;
+		allocator.write(b, &value, sizeof(value));
+
+		REQUIRE(allocator.free(a) > 0);
+		REQUIRE(allocator.free(a) == 0);
+
+		int readback = 0;
+		allocator.read(&readback, b, sizeof(readback));
+		REQUIRE(readback == value);
+	}
+
+	SECTION("Repeated accesses hit the TLB") {
+		Address address = allocator.allocate(sizeof(int));
+		int value = 10;
+		allocator.write(address, &value, sizeof(value));
+
+		int reads_before = access_counter.reads();
+		uint32_t hits_before = allocator.tlb_hits();
+		for (int i = 0; i < 10; i++) {
+			allocator.read(&value, address, sizeof(value));
+		}
+
+		// only the data itself is read, no page table entries
+		REQUIRE(access_counter.reads() == reads_before + 10);
+		REQUIRE(allocator.tlb_hits() == hits_before + 10);
+	}
+
+	SECTION("External pointers work in virtual memory") {
+		TemplateAllocator template_allocator{allocator};
+		auto ptr = template_allocator.make_external<int>(7);
+		int value = *ptr;
+		REQUIRE(value == 7);
+		*ptr = 8;
+		value = *ptr;
+		REQUIRE(value == 8);
+		ptr.free();
+	}
+}
+
+// Keeps a few allocations of varying sizes alive, freeing the oldest first
+template <typename Allocator> void churn(Allocator &allocator, int cycles) {
+	constexpr int window = 4;
+	const Size sizes[] = {100, 24, 200, 60, 8};
+	Address live[window] = {};
+	const Size before = allocator.get_free_bytes();
+
+	for (int i = 0; i < cycles; i++) {
+		Address &address = live[i % window];
+		if (address) {
+			int value = 0;
+			allocator.read(&value, address, sizeof(value));
+			REQUIRE(value == i - window);
+			REQUIRE(allocator.free(address) > 0);
+		}
+		address = allocator.allocate(sizes[i % 5]);
+		REQUIRE(address);
+		REQUIRE(allocator.write(address, &i, sizeof(i)));
+	}
+
+	for (Address address : live) {
+		allocator.free(address);
+	}
+	// pages and page tables are all released
+	REQUIRE(allocator.get_free_bytes() == before);
+}
+
+TEST_CASE("Virtual allocator reuses freed space", "[virtual_allocator]") {
+	SECTION("Small address space") {
+		constexpr Size memory_size = 4096;
+		MockMemoryDevice<memory_size> memory_device{};
+		VirtualAllocator<64, 8, 16> allocator{memory_device,
+											  Address(memory_size)};
+		// wraps the 64 KiB of virtual space several times
+		churn(allocator, 4000);
+	}
+
+	SECTION("Deep page tables") {
+		constexpr Size memory_size = 16 * 1024;
+		static MockMemoryDevice<memory_size> memory_device{};
+		VirtualAllocator<256> allocator{memory_device, Address(memory_size)};
+		churn(allocator, 20000);
+	}
+}
@@ -0,0 +1,111 @@
+#include "../layers/access_counter.hpp"
+#include "../layers/write_combining_layer.hpp"
+#include "../mocks/mock_memory_device.hpp"
+#include <catch2/catch_all.hpp>
+
+using namespace rambock;
+using namespace mocks;
+using namespace layers;
+
+TEST_CASE("write combining layer merges writes", "[layers]") {
+	constexpr Size memory_size = 1024;
+	constexpr Size buffer_size = 64;
+	constexpr Size max_ranges = 4;
+	Address address = Address{100};
+
+	MockMemoryDevice<memory_size> mock_memory_device{};
+	AccessCounter access_counter{mock_memory_device};
+	WriteCombiningLayer<buffer_size, max_ranges> combining_layer{
+		access_counter};
+
+	SECTION("writes are held back until flushed") {
+		int value = 10;
+		combining_layer.write(address, &value, sizeof(value));
+		REQUIRE(access_counter.writes() == 0);
+
+		combining_layer.flush();
+		REQUIRE(access_counter.writes() == 1);
+
+		int readback = 0;
+		mock_memory_device.read(&readback, address, sizeof(readback));
+		REQUIRE(readback == value);
+	}
+
+	SECTION("adjacent writes become one transfer") {
+		int values[] = {1, 2, 3, 4};
+		// Write out of order to exercise insertion
+		for (Size i : {2, 0, 3, 1}) {
+			combining_layer.write(
+				address + i * sizeof(int), &values[i], sizeof(int));
+		}
+		REQUIRE(combining_layer.pending_ranges() == 1);
+
+		combining_layer.flush();
+		REQUIRE(access_counter.writes() == 1);
+
+		int readback[4] = {};
+		mock_memory_device.read(&readback, address, sizeof(readback));
+		REQUIRE(memcmp(readback, values, sizeof(values)) == 0);
+	}
+
+	SECTION("overlapping writes keep the latest data") {
+		uint8_t old_data[8];
+		memset(old_data, 1, sizeof(old_data));
+		uint8_t new_data[4];
+		memset(new_data, 2, sizeof(new_data));
+
+		combining_layer.write(address, &old_data, sizeof(old_data));
+		combining_layer.write(address + 2, &new_data, sizeof(new_data));
+		REQUIRE(combining_layer.pending_bytes() == sizeof(old_data));
+
+		uint8_t expected[] = {1, 1, 2, 2, 2, 2, 1, 1};
+		uint8_t readback[8] = {};
+		combining_layer.read(&readback, address, sizeof(readback));
+		REQUIRE(access_counter.reads() == 0);
+		REQUIRE(memcmp(readback, expected, sizeof(expected)) == 0);
+	}
+
+	SECTION("a write bridging two ranges merges them") {
+		int value = 5;
+		combining_layer.write(address, &value, sizeof(value));
+		combining_layer.write(address + 8, &value, sizeof(value));
+		REQUIRE(combining_layer.pending_ranges() == 2);
+
+		combining_layer.write(address + 4, &value, sizeof(value));
+		REQUIRE(combining_layer.pending_ranges() == 1);
+
+		int readback[3] = {};
+		combining_layer.read(&readback, address, sizeof(readback));
+		REQUIRE(readback[0] == value);
+		REQUIRE(readback[1] == value);
+		REQUIRE(readback[2] == value);
+	}
+
+	SECTION("partially pending reads drain first") {
+		int value = 7;
+		combining_layer.write(address, &value, sizeof(value));
+
+		int readback[2] = {};
+		combining_layer.read(&readback, address, sizeof(readback));
+		REQUIRE(readback[0] == value);
+		REQUIRE(access_counter.writes() == 1);
+		REQUIRE(combining_layer.pending_ranges() == 0);
+	}
+
+	SECTION("running out of ranges drains") {
+		int value = 3;
+		for (Size i = 0; i <= max_ranges; i++) {
+			combining_layer.write(
+				address + i * 2 * sizeof(int), &value, sizeof(value));
+		}
+		REQUIRE(access_counter.writes() == max_ranges);
+		REQUIRE(combining_layer.pending_ranges() == 1);
+	}
+
+	SECTION("large writes pass through") {
+		uint8_t large[buffer_size * 2] = {};
+		combining_layer.write(address, &large, sizeof(large));
+		REQUIRE(access_counter.writes() == 1);
+		REQUIRE(combining_layer.pending_bytes() == 0);
+	}
+}
@@ -0,0 +1,532 @@
+/** Offline cache simulator
+ * Feeds an access trace recorded by TraceRecorder, or a synthetic access
+ * pattern, through many cache configurations in a single pass and prints hit
+ * rates, bytes moved over the bus and an estimate of the time the bus was busy
+ * for each of them.
+ *
+ * Caches are modelled after CacheLayer (a single window) and LRUCacheLayer
+ * (lines with LRU replacement per set), each with a write-back and a
+ * write-through policy. Fills count as writes, copies and moves as a read of
+ * the source and a write of the destination. Dirty data is written back at the
+ * end, as if the cache was flushed.
+ *
+ * Usage:
+ *   cache_simulator --trace=<file>
+ *   cache_simulator --pattern=<sequential|strided|random|interleaved|hotspot>
+ *                   [--accesses=N] [--access_size=N] [--memory=N]
+ *                   [--stride=N] [--writes=PERCENT] [--seed=N]
+ * Options for both:
+ *   --sizes=64,256,...     cache sizes in bytes
+ *   --line_sizes=16,32,... line sizes in bytes
+ *   --ways=1,2,0,...       associativity, 0 is fully associative
+ *   --overhead=NS          bus time per transaction
+ *   --byte_time=NS         bus time per byte
+ *   --csv                  print CSV instead of a table
+ *
+ * The default bus timing is that of a 23LC1024 at 20 MHz, which sends four
+ * bytes of command and address ahead of the data of every transaction.
+ */
+#include "../layers/trace_recorder.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace rambock;
+using layers::TraceRecorder;
+
+namespace {
+
+/** Traffic passed on to the underlying device
+ */
+struct Bus {
+	uint64_t transactions, read_bytes, written_bytes;
+
+	inline void read(uint64_t count) {
+		transactions++;
+		read_bytes += count;
+	}
+	inline void write(uint64_t count) {
+		transactions++;
+		written_bytes += count;
+	}
+};
+
+enum Policy {
+	WRITE_BACK,
+	WRITE_THROUGH,
+};
+
+inline const char *policy_name(Policy policy) {
+	return policy == WRITE_BACK ? "write-back" : "write-through";
+}
+
+/** A cache configuration being simulated
+ * An access hits if all of its bytes were cached.
+ */
+struct Simulation {
+	virtual ~Simulation() = default;
+
+	virtual void access(bool is_write, uint32_t address, uint32_t count) = 0;
+	// write back all dirty data
+	virtual void flush() = 0;
+
+	std::string name;
+	uint64_t hits = 0, misses = 0;
+	Bus bus{};
+};
+
+/** Every access goes to the device
+ */
+struct Uncached : Simulation {
+	Uncached() { name = "uncached"; }
+
+	void access(bool is_write, uint32_t, uint32_t count) override {
+		misses++;
+		if (is_write) {
+			bus.write(count);
+		} else {
+			bus.read(count);
+		}
+	}
+	void flush() override {}
+};
+
+/** Single window of size bytes starting at the most recent missed address
+ * Like CacheLayer, modifications are tracked in chunks of four bytes and
+ * adjacent dirty chunks are written back together. Accesses larger than the
+ * window bypass it.
+ */
+struct Window : Simulation {
+	static constexpr uint32_t CHUNK_SIZE = 4;
+
+	Window(uint32_t size, Policy policy)
+		: _size{size}
+		, _policy{policy}
+		, _begin{0}
+		, _valid{false}
+		, _dirty((size + CHUNK_SIZE - 1) / CHUNK_SIZE) {
+		name = "window " + std::to_string(size) + " " + policy_name(policy);
+	}
+
+	void access(bool is_write, uint32_t address, uint32_t count) override {
+		const uint64_t end = uint64_t(address) + count;
+		const bool cached =
+			_valid && address >= _begin && end <= uint64_t(_begin) + _size;
+		if (cached) {
+			hits++;
+		} else {
+			misses++;
+			flush();
+			if (count > _size) {
+				_valid = false;
+				if (is_write) {
+					bus.write(count);
+				} else {
+					bus.read(count);
+				}
+				return;
+			}
+			_begin = address;
+			_valid = true;
+			bus.read(_size);
+		}
+
+		if (!is_write) {
+			return;
+		}
+		if (_policy == WRITE_THROUGH) {
+			bus.write(count);
+			return;
+		}
+		const uint32_t offset = address - _begin;
+		for (uint32_t chunk = offset / CHUNK_SIZE;
+			 chunk * CHUNK_SIZE < offset + count;
+			 chunk++) {
+			_dirty[chunk] = true;
+		}
+	}
+
+	void flush() override {
+		size_t chunk = 0;
+		while (chunk < _dirty.size()) {
+			if (!_dirty[chunk]) {
+				chunk++;
+				continue;
+			}
+			const size_t first = chunk;
+			while (chunk < _dirty.size() && _dirty[chunk]) {
+				_dirty[chunk++] = false;
+			}
+			uint64_t end = chunk * CHUNK_SIZE;
+			end = end < _size ? end : _size;
+			bus.write(end - first * CHUNK_SIZE);
+		}
+	}
+
+  private:
+	uint32_t _size;
+	Policy _policy;
+	uint32_t _begin;
+	bool _valid;
+	std::vector<bool> _dirty;
+};
+
+constexpr uint32_t Window::CHUNK_SIZE;
+
+/** Lines of line_size bytes in sets of ways lines with LRU replacement
+ * Write-back caches allocate lines on writes, fetching them unless a write
+ * covers the whole line. Write-through caches pass every write on and only
+ * update lines already cached.
+ */
+struct Lines : Simulation {
+	Lines(uint32_t size, uint32_t line_size, uint32_t ways, Policy policy)
+		: _line_size{line_size}
+		, _ways{ways}
+		, _sets{size / line_size / ways}
+		, _policy{policy}
+		, _clock{0}
+		, _lines(size / line_size) {
+		name = "lines " + std::to_string(size) + "/" +
+			   std::to_string(line_size) + "x" +
+			   (_sets == 1 ? std::string("full") : std::to_string(ways)) + " " +
+			   policy_name(policy);
+	}
+
+	void access(bool is_write, uint32_t address, uint32_t count) override {
+		if (is_write && _policy == WRITE_THROUGH) {
+			bus.write(count);
+		}
+		bool hit = true;
+		const uint64_t end = uint64_t(address) + (count ? count : 1);
+		for (uint64_t line = address / _line_size; line * _line_size < end;
+			 line++) {
+			const uint64_t first = line * _line_size;
+			const bool whole = address <= first && first + _line_size <= end;
+			hit &= touch(line, is_write, whole);
+		}
+		if (hit) {
+			hits++;
+		} else {
+			misses++;
+		}
+	}
+
+	void flush() override {
+		for (Line &line : _lines) {
+			if (line.valid && line.dirty) {
+				bus.write(_line_size);
+				line.dirty = false;
+			}
+		}
+	}
+
+  private:
+	struct Line {
+		uint64_t tag, used;
+		bool valid, dirty;
+	};
+
+	/** Access a single line
+	 * @param whole true if a write covers the whole line
+	 * @return true on a hit
+	 */
+	bool touch(uint64_t tag, bool is_write, bool whole) {
+		Line *set = &_lines[(tag % _sets) * _ways];
+		Line *victim = set;
+		for (uint32_t way = 0; way < _ways; way++) {
+			Line &line = set[way];
+			if (line.valid && line.tag == tag) {
+				line.used = ++_clock;
+				line.dirty |= is_write && _policy == WRITE_BACK;
+				return true;
+			}
+			if (!line.valid || (victim->valid && line.used < victim->used)) {
+				victim = &line;
+			}
+		}
+
+		if (is_write && _policy == WRITE_THROUGH) {
+			return false;
+		}
+		if (victim->valid && victim->dirty) {
+			bus.write(_line_size);
+		}
+		if (!(is_write && whole)) {
+			bus.read(_line_size);
+		}
+		*victim = Line{tag, ++_clock, true, is_write};
+		return false;
+	}
+
+	uint32_t _line_size, _ways, _sets;
+	Policy _policy;
+	uint64_t _clock;
+	std::vector<Line> _lines;
+};
+
+struct Options {
+	std::string trace, pattern;
+	uint64_t accesses = 100000;
+	uint32_t access_size = 4;
+	uint32_t memory = 1 << 17;
+	uint32_t stride = 64;
+	uint32_t writes = 30;
+	uint32_t seed = 1;
+	std::vector<uint32_t> sizes{64, 256, 1024, 4096};
+	std::vector<uint32_t> line_sizes{16, 32, 64};
+	std::vector<uint32_t> ways{1, 2, 0};
+	double overhead = 1600;
+	double byte_time = 400;
+	bool csv = false;
+};
+
+// get the value of --name=value, nullptr if argument is another option
+const char *option(const char *argument, const char *name) {
+	const size_t length = strlen(name);
+	if (strncmp(argument, "--", 2) != 0 ||
+		strncmp(argument + 2, name, length) != 0 ||
+		argument[2 + length] != '=') {
+		return nullptr;
+	}
+	return argument + 3 + length;
+}
+
+bool parse_list(const char *value, std::vector<uint32_t> &list) {
+	list.clear();
+	while (*value) {
+		char *end = nullptr;
+		list.push_back(uint32_t(strtoul(value, &end, 0)));
+		if (end == value || (*end && *end != ',')) {
+			return false;
+		}
+		value = *end ? end + 1 : end;
+	}
+	return !list.empty();
+}
+
+bool parse(int argc, char **argv, Options &options) {
+	for (int i = 1; i < argc; i++) {
+		const char *argument = argv[i];
+		const char *value = nullptr;
+		if (strcmp(argument, "--csv") == 0) {
+			options.csv = true;
+		} else if ((value = option(argument, "trace"))) {
+			options.trace = value;
+		} else if ((value = option(argument, "pattern"))) {
+			options.pattern = value;
+		} else if ((value = option(argument, "accesses"))) {
+			options.accesses = strtoull(value, nullptr, 0);
+		} else if ((value = option(argument, "access_size"))) {
+			options.access_size = uint32_t(strtoul(value, nullptr, 0));
+		} else if ((value = option(argument, "memory"))) {
+			options.memory = uint32_t(strtoul(value, nullptr, 0));
+		} else if ((value = option(argument, "stride"))) {
+			options.stride = uint32_t(strtoul(value, nullptr, 0));
+		} else if ((value = option(argument, "writes"))) {
+			options.writes = uint32_t(strtoul(value, nullptr, 0));
+		} else if ((value = option(argument, "seed"))) {
+			options.seed = uint32_t(strtoul(value, nullptr, 0));
+		} else if ((value = option(argument, "sizes"))) {
+			if (!parse_list(value, options.sizes)) {
+				return false;
+			}
+		} else if ((value = option(argument, "line_sizes"))) {
+			if (!parse_list(value, options.line_sizes)) {
+				return false;
+			}
+		} else if ((value = option(argument, "ways"))) {
+			if (!parse_list(value, options.ways)) {
+				return false;
+			}
+		} else if ((value = option(argument, "overhead"))) {
+			options.overhead = strtod(value, nullptr);
+		} else if ((value = option(argument, "byte_time"))) {
+			options.byte_time = strtod(value, nullptr);
+		} else {
+			fprintf(stderr, "unknown option %s\n", argument);
+			return false;
+		}
+	}
+	if (options.trace.empty() == options.pattern.empty()) {
+		fprintf(stderr, "expected either --trace or --pattern\n");
+		return false;
+	}
+	if (options.access_size == 0 || options.memory < options.access_size) {
+		fprintf(stderr, "memory must hold at least one access\n");
+		return false;
+	}
+	return true;
+}
+
+std::vector<std::unique_ptr<Simulation>> configure(const Options &options) {
+	std::vector<std::unique_ptr<Simulation>> simulations{};
+	simulations.emplace_back(new Uncached{});
+	const Policy policies[] = {WRITE_BACK, WRITE_THROUGH};
+	for (uint32_t size : options.sizes) {
+		if (size == 0) {
+			continue;
+		}
+		for (Policy policy : policies) {
+			simulations.emplace_back(new Window{size, policy});
+		}
+		for (uint32_t line_size : options.line_sizes) {
+			if (line_size == 0 || line_size > size || size % line_size) {
+				continue;
+			}
+			const uint32_t line_count = size / line_size;
+			std::vector<uint32_t> done{};
+			for (uint32_t ways : options.ways) {
+				ways = ways ? ways : line_count;
+				if (ways > line_count || line_count % ways ||
+					std::find(done.begin(), done.end(), ways) != done.end()) {
+					continue;
+				}
+				done.push_back(ways);
+				for (Policy policy : policies) {
+					simulations.emplace_back(
+						new Lines{size, line_size, ways, policy});
+				}
+			}
+		}
+	}
+	return simulations;
+}
+
+/** Generates synthetic accesses
+ * @return false if the pattern is unknown
+ */
+template <typename Visit> bool generate(const Options &options, Visit visit) {
+	std::mt19937 random{options.seed};
+	const uint32_t size = options.access_size;
+	const uint32_t slots = options.memory / size;
+	auto is_write = [&] { return random() % 100 < options.writes; };
+
+	for (uint64_t i = 0; i < options.accesses; i++) {
+		uint64_t slot = 0;
+		if (options.pattern == "sequential") {
+			slot = i % slots;
+		} else if (options.pattern == "strided") {
+			slot = (i * (options.stride / size ? options.stride / size : 1)) %
+				   slots;
+		} else if (options.pattern == "random") {
+			slot = random() % slots;
+		} else if (options.pattern == "interleaved") {
+			// two regions far apart revisiting a small working set
+			slot = (i / 2) % 64 % slots + (i % 2) * (slots / 2);
+		} else if (options.pattern == "hotspot") {
+			// nine in ten accesses go to the first sixteenth of memory
+			const uint64_t hot = slots / 16 ? slots / 16 : 1;
+			slot = random() % 10 ? random() % hot : random() % slots;
+		} else {
+			return false;
+		}
+		visit(is_write(), uint32_t(slot * size), size);
+	}
+	return true;
+}
+
+void print(const Options &options,
+		   const std::vector<std::unique_ptr<Simulation>> &simulations) {
+	if (options.csv) {
+		printf("configuration,hits,misses,hit_rate,transactions,"
+			   "read_bytes,written_bytes,bus_time_us\n");
+	} else {
+		printf("%-36s %10s %10s %7s %12s %12s %12s %12s\n",
+			   "configuration",
+			   "hits",
+			   "misses",
+			   "hits %",
+			   "transactions",
+			   "read bytes",
+			   "written bytes",
+			   "bus time us");
+	}
+	for (const auto &simulation : simulations) {
+		const Bus &bus = simulation->bus;
+		const uint64_t accesses = simulation->hits + simulation->misses;
+		const double hit_rate =
+			accesses ? 100.0 * double(simulation->hits) / double(accesses) : 0;
+		const double time =
+			(double(bus.transactions) * options.overhead +
+			 double(bus.read_bytes + bus.written_bytes) * options.byte_time) /
+			1000;
+		printf(options.csv ? "%s,%llu,%llu,%.2f,%llu,%llu,%llu,%.1f\n"
+						   : "%-36s %10llu %10llu %7.2f %12llu %12llu %12llu "
+							 "%12.1f\n",
+			   simulation->name.c_str(),
+			   (unsigned long long)simulation->hits,
+			   (unsigned long long)simulation->misses,
+			   hit_rate,
+			   (unsigned long long)bus.transactions,
+			   (unsigned long long)bus.read_bytes,
+			   (unsigned long long)bus.written_bytes,
+			   time);
+	}
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	Options options{};
+	if (!parse(argc, argv, options)) {
+		fprintf(stderr,
+				"usage: %s --trace=<file> | --pattern=<sequential|strided|"
+				"random|interleaved|hotspot> [options]\n",
+				argv[0]);
+		return 1;
+	}
+
+	std::vector<std::unique_ptr<Simulation>> simulations = configure(options);
+	auto visit = [&](bool is_write, uint32_t address, uint32_t count) {
+		for (auto &simulation : simulations) {
+			simulation->access(is_write, address, count);
+		}
+	};
+
+	if (!options.trace.empty()) {
+		std::ifstream file{options.trace, std::ios::binary};
+		if (!file) {
+			fprintf(stderr, "cannot open %s\n", options.trace.c_str());
+			return 1;
+		}
+		const std::vector<uint8_t> trace{std::istreambuf_iterator<char>{file},
+										 std::istreambuf_iterator<char>{}};
+		TraceRecorder::Reader reader{trace.data(), trace.size()};
+		TraceRecorder::Record record{};
+		while (reader.next(record)) {
+			switch (record.operation) {
+			case TraceRecorder::READ:
+				visit(false, record.address.value, record.size);
+				break;
+			case TraceRecorder::WRITE:
+			case TraceRecorder::FILL:
+				visit(true, record.address.value, record.size);
+				break;
+			case TraceRecorder::COPY:
+			case TraceRecorder::MOVE:
+				visit(false, record.source.value, record.size);
+				visit(true, record.address.value, record.size);
+				break;
+			}
+		}
+		if (!reader.done()) {
+			fprintf(stderr, "trace is malformed, stopped early\n");
+		}
+	} else if (!generate(options, visit)) {
+		fprintf(stderr, "unknown pattern %s\n", options.pattern.c_str());
+		return 1;
+	}
+
+	for (auto &simulation : simulations) {
+		simulation->flush();
+	}
+	print(options, simulations);
+	return 0;
+}